@@ -12,23 +12,43 @@
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include "hexToBytes.h"
+#include "key_cache.h"
 
 
 
 
 class DataMessage{
     public:
+        // Number of fingerprint characters in a key ID. The fingerprint is the base64 of the hex digest, so this is 6 hex
+        // characters (24 bits), recipients sharing an ID just try each of the matching symmetric keys
+        static const size_t keyIdLength = 8;
+
+        /*
+            Returns the short ID of a key, sent in "symm_key_ids" next to the symmetric key encrypted with it so a
+            recipient can pick out its own symmetric key instead of trying to decrypt every one.
+            The ID is the start of the key's fingerprint.
+        */
+        static std::string keyId(EVP_PKEY* key){
+            return KeyCache::fingerprint(key).substr(0, keyIdLength);
+        }
+
         /* 
             Used for creating the data in a chat message, currently missing client-info and time-to-die
             Returns the resultant string to be provided to the websocket or to be signed in signed_data function.
 
             Need to add client and server id will ask around
+
+            recipient_fingerprints are the fingerprints of the recipients' keys, sent in "recipients" so servers only deliver
+            the chat to its recipients rather than every client. Left out if empty.
         */
-        static std::string generateDataMessage(std::string text, std::vector<EVP_PKEY*> public_keys, std::vector<std::string> server_addresses, std::string ttd){
+        static std::string generateDataMessage(std::string text, std::vector<EVP_PKEY*> public_keys, std::vector<std::string> server_addresses, std::string ttd, std::vector<std::string> recipient_fingerprints = std::vector<std::string>()){
             nlohmann::json data;
             data["type"] = "chat";
             data["time-to-die"] = ttd;
             data["destination_servers"] = server_addresses;
+            if(!recipient_fingerprints.empty()){
+                data["recipients"] = recipient_fingerprints;
+            }
             // Generate random AES key
             std::vector<unsigned char> key(AES_GCM_KEY_SIZE);
             if (!RAND_bytes(key.data(), AES_GCM_KEY_SIZE)) {
@@ -63,6 +83,7 @@ class DataMessage{
                 if ((symm_key_len = Client_Key_Gen::rsaEncrypt(public_key, key_encoded, base64Key.length(), &symm_key))) {
                     std::string symm_key_string(reinterpret_cast<char*>(symm_key), symm_key_len);
                     data["symm_keys"].push_back(Base64::encode(symm_key_string));
+                    data["symm_key_ids"].push_back(keyId(public_key));
                     OPENSSL_free(symm_key); // Free the allocated memory
                 } else {
                     std::cerr << "Error encrypting symmetric key." << std::endl;
@@ -20,6 +20,7 @@ class Fingerprint{
             char * pemKey = nullptr;
             long pemLen = BIO_get_mem_data(bio, &pemKey);
             std::string publicKeyStr(pemKey, pemLen);
+            BIO_free(bio);
             std::string hashedKey = Sha256Hash::hashStringSha256(publicKeyStr);
             std::string encodedHash = Base64::encode(hashedKey);
 
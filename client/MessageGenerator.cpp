@@ -3,6 +3,7 @@
 #include "ChatMessage.h"
 #include "DataMessage.h"
 #include "Fingerprint.h"
+#include "key_cache.h"
 #include "HelloMessage.h"
 #include "PublicChatMessage.h"
 #include "client_signature.h"
@@ -14,18 +15,20 @@ std::string MessageGenerator::chatMessage(std::string message, EVP_PKEY * your_p
     std::vector<std::string> fingerprints; // Store fingerprints of participants
 
     // Add your own fingerprint first
-    fingerprints.push_back(Fingerprint::generateFingerprint(your_public_key));
+    fingerprints.push_back(KeyCache::fingerprint(your_public_key));
 
-    // Add the fingerprints of the recipients
+    // Add the fingerprints of the recipients, keys taken from the key cache are not fingerprinted again
     for (auto key: their_public_keys){
-        fingerprints.push_back(Fingerprint::generateFingerprint(key));
+        fingerprints.push_back(KeyCache::fingerprint(key));
     }
 
     // Generate a chat message in JSON format, embedding the message and participant fingerprints
     std::string chat_message = ChatMessage::generateChatMessage(message, fingerprints);
 
-    // Encrypt the chat message using the recipient's public keys and destination server list
-    data = DataMessage::generateDataMessage(chat_message, their_public_keys, destination_servers_vector, ttd);
+    // Encrypt the chat message using the recipient's public keys and destination server list, naming the recipients
+    // (every participant but the sender) so servers only deliver it to them
+    std::vector<std::string> recipients(fingerprints.begin() + 1, fingerprints.end());
+    data = DataMessage::generateDataMessage(chat_message, their_public_keys, destination_servers_vector, ttd, recipients);
 
     // Sign the encrypted message with the client's private key and a message counter
     nlohmann::json signed_message;
@@ -47,6 +50,9 @@ std::string MessageGenerator::clientListRequestMessage(){
     // Set the type of message to 'client_list_request'
     client_list_request["type"] = "client_list_request";
 
+    // Ask for client_list_delta messages after this list, servers that don't support them ignore this
+    client_list_request["delta"] = true;
+
     // Convert the JSON object to a string and return it
     return client_list_request.dump();
 }
@@ -52,12 +52,18 @@ class MessageGenerator{
                     "symm_keys": [
                         "<Base64 encoded AES key, encrypted with each recipient's public RSA key>",
                     ],
+                    "symm_key_ids": [
+                        "<First 8 characters of the fingerprint of the key each symm_keys entry was encrypted with>",
+                    ],
                     "chat": "<Base64 encoded AES encrypted segment>",
                     "client-info":{
                         "client-id":"<client-id>",
                         "server-id":"<server-id>"
                     },
-                    "time-to-die":"UTC-Timestamp"
+                    "time-to-die":"UTC-Timestamp",
+                    "recipients": [
+                        "<Fingerprint of each recipient, servers deliver the chat only to these clients>",
+                    ]
                 }
             }
             Chat format
@@ -105,8 +111,10 @@ class MessageGenerator{
 
             {
                 "type": "client_list_request",
+                "delta": true
             }
             This is NOT signed and does NOT follow the data format.
+            "delta" asks the server to send only the clients that joined or left (client_list_delta) after this list.
        */
         static std::string clientListRequestMessage();
 
@@ -7,18 +7,26 @@ ClientList::ClientList(){}
 // Stores an unordered_map<client_id, public_key> against each server's ID
 // Stores a map of server addresses against each server's ID 
 void ClientList::update(nlohmann::json data){
+    // Keys of the previous list are released after the new list has acquired its keys, so keys in both are not parsed again
+    std::vector<KeyPool::Key> previousKeys;
+    for(const auto& server: servers){
+        for(const auto& client: server.second){
+            previousKeys.push_back(client.second);
+        }
+    }
+
     servers.clear();
     clientFingerprintsKeys.clear();
     serverAddresses.clear();
 
     if (data.contains("servers")){
         for (const auto& server: data["servers"]){
-            std::unordered_map<int, std::string> client_list;
-            std::unordered_map<std::string, std::string> fingerprintsKeys;
+            FlatMap<int, KeyPool::Key> client_list;
             if(server.contains("server-id") && server.contains("address")){
 
             }else{
                 std::cerr << "Invalid JSON" << std::endl;
+                releaseKeys(previousKeys);
                 return;
             }
             int server_id = server["server-id"];
@@ -41,19 +49,113 @@ void ClientList::update(nlohmann::json data){
                     } else {
                         std::string public_key = client["public-key"];
 
-                        std::string fingerprint = Fingerprint::generateFingerprint(Client_Key_Gen::stringToPEM(public_key));
-                        std::pair<int, std::string> clientIDKey(client_id, public_key);
-                        clientFingerprintsKeys[fingerprint] = std::pair<int, std::pair<int, std::string>>(server_id, clientIDKey);
+                        if(client_list.find(client_id) != client_list.end() || !KeyCache::acquire(public_key)){
+                            continue;
+                        }
+                        FingerprintDigest fingerprint = KeyCache::digest(public_key);
+                        KeyPool::Key key = KeyPool::intern(public_key);
+                        std::pair<int, KeyPool::Key> clientIDKey(client_id, key);
+                        clientFingerprintsKeys[fingerprint] = std::pair<int, std::pair<int, KeyPool::Key>>(server_id, clientIDKey);
 
-                        client_list.insert(std::pair<int, std::string>(client_id, public_key));
+                        client_list.insert(std::pair<int, KeyPool::Key>(client_id, key));
                     }
 
                 }
-                servers.insert(std::pair<int, std::unordered_map<int, std::string>>(server_id, client_list));
+                servers.insert(std::pair<int, FlatMap<int, KeyPool::Key>>(server_id, client_list));
             }
             
         }
     }
+    releaseKeys(previousKeys);
+
+    // Servers that support deltas send the version of the list
+    if(data.contains("version") && data["version"].is_number_integer()){
+        version = data["version"].get<long long>();
+    }else{
+        version = -1;
+    }
+}
+
+// Applies a client_list_delta of the clients that joined or left since the last client list.
+// Returns false if the delta does not follow on from the current list, in which case the full list should be requested again.
+bool ClientList::applyDelta(nlohmann::json data){
+    if(!data.contains("from") || !data.contains("version") || !data["from"].is_number_integer() || !data["version"].is_number_integer()){
+        std::cerr << "Invalid JSON" << std::endl;
+        return false;
+    }
+    if(version < 0 || data["from"].get<long long>() != version){
+        return false;
+    }
+
+    if(data.contains("removed")){
+        for(const auto& client: data["removed"]){
+            if(client.contains("server-id") && client.contains("client-id")){
+                removeClient(client["server-id"], client["client-id"]);
+            }
+        }
+    }
+
+    if(data.contains("added")){
+        for(const auto& client: data["added"]){
+            if(!client.contains("server-id") || !client.contains("client-id") || !client.contains("public-key")){
+                std::cerr << "Invalid JSON" << std::endl;
+                continue;
+            }
+            int server_id = client["server-id"];
+            int client_id = client["client-id"];
+            std::string public_key = client["public-key"];
+            if(client.contains("address")){
+                serverAddresses[server_id] = client["address"];
+            }
+
+            // Replace the client if their key has changed
+            auto found = servers[server_id].find(client_id);
+            if(found != servers[server_id].end()){
+                if(*found->second == public_key){
+                    continue;
+                }
+                removeClient(server_id, client_id);
+            }
+            if(!KeyCache::acquire(public_key)){
+                continue;
+            }
+            KeyPool::Key key = KeyPool::intern(public_key);
+            servers[server_id][client_id] = key;
+            clientFingerprintsKeys[KeyCache::digest(public_key)] = {server_id, {client_id, key}};
+        }
+    }
+
+    version = data["version"].get<long long>();
+    return true;
+}
+
+// Removes a client from the list and releases their key
+void ClientList::removeClient(int server_id, int client_id){
+    auto server = servers.find(server_id);
+    if(server == servers.end()){
+        return;
+    }
+    auto client = server->second.find(client_id);
+    if(client == server->second.end()){
+        return;
+    }
+
+    // Only remove the fingerprint if it still belongs to this client
+    FingerprintDigest fingerprint = KeyCache::digest(*client->second);
+    auto fingerprintKey = clientFingerprintsKeys.find(fingerprint);
+    if(fingerprintKey != clientFingerprintsKeys.end() && fingerprintKey->second.first == server_id && fingerprintKey->second.second.first == client_id){
+        clientFingerprintsKeys.erase(fingerprintKey);
+    }
+
+    KeyCache::release(*client->second);
+    server->second.erase(client);
+}
+
+// Releases keys that are no longer stored in the client list from the key cache
+void ClientList::releaseKeys(const std::vector<KeyPool::Key>& keys){
+    for(const auto& key: keys){
+        KeyCache::release(*key);
+    }
 }
 
 // Retrieves a server address using a server ID. Returns an empty string if the server ID is invalid.
@@ -87,7 +189,7 @@ std::pair<int, std::string> ClientList::retrieveClient(int server_id, int client
         // Check if the client exists in the server
         auto& client_list = servers[server_id];
         if (client_list.find(client_id) != client_list.end()) {
-            return {client_id, client_list[client_id]};
+            return {client_id, *client_list[client_id]};
         } else {
             std::cerr << "Client ID not found." << std::endl;
             return {server_id, ""};
@@ -99,9 +201,14 @@ std::pair<int, std::string> ClientList::retrieveClient(int server_id, int client
 }
 
 // Retrieve the senders public key using their fingerprint (will be useful for signature verification on client)
-std::pair<int, std::pair<int, std::string>> ClientList::retrieveClientFromFingerprint(std::string fingerprint) {
-    if(clientFingerprintsKeys.find(fingerprint) != clientFingerprintsKeys.end()){
-        return clientFingerprintsKeys[fingerprint];
+std::pair<int, std::pair<int, std::string>> ClientList::retrieveClientFromFingerprint(const std::string& fingerprint) {
+    return retrieveClientFromFingerprint(FingerprintDigest::fromText(fingerprint));
+}
+
+std::pair<int, std::pair<int, std::string>> ClientList::retrieveClientFromFingerprint(const FingerprintDigest& fingerprint) {
+    auto found = clientFingerprintsKeys.find(fingerprint);
+    if(found != clientFingerprintsKeys.end()){
+        return {found->second.first, {found->second.second.first, *found->second.second.second}};
     }else{
         return {-1, {-1, ""}};
     }
@@ -3,28 +3,40 @@
 #include <string>
 #include <unordered_map>
 #include <utility> //For pair
+#include <vector>
 #include <nlohmann/json.hpp> // For JSON library
 #include <iostream>
 
 #include "client_key_gen.h"
 #include "Fingerprint.h"
+#include "key_cache.h"
+#include "key_pool.h"
+#include "fingerprint_digest.h"
+#include "flat_map.h"
 
 /* For implementing later on when introducing fingerprints, create a struct that points to both the public_key and SHA256(Public Key)*/
 
 class ClientList{
     private:
     // Idea being that each server maps to another map, this ensure that we can access each server from their ID and each client from their server ID.
-        std::unordered_map<int, std::unordered_map<int, std::string>> servers;
-        std::unordered_map<std::string, std::pair<int, std::pair<int, std::string>>> clientFingerprintsKeys;
+        // Public keys are interned in the KeyPool, so both maps point to the same copy of each key
+        FlatMap<int, FlatMap<int, KeyPool::Key>> servers;
+        FlatMap<FingerprintDigest, std::pair<int, std::pair<int, KeyPool::Key>>, FingerprintDigest::Hash> clientFingerprintsKeys;
         std::unordered_map<int, std::string> serverAddresses;
         int clientCount;
+        long long version = -1; // Version of the last client list from the server, -1 if it didn't send one
+
+        void releaseKeys(const std::vector<KeyPool::Key>& keys);
+        void removeClient(int server_id, int client_id);
     public:
         ClientList();
         void update(nlohmann::json data);
+        bool applyDelta(nlohmann::json data);
         void printUsers(int server_id, int client_id);
         std::pair<int, std::string> retrieveClient(int server_id, int client_id);
         std::string retrieveAddress(int server_id);
-        std::pair<int, std::pair<int, std::string>> retrieveClientFromFingerprint(std::string fingerprint);
+        std::pair<int, std::pair<int, std::string>> retrieveClientFromFingerprint(const std::string& fingerprint);
+        std::pair<int, std::pair<int, std::string>> retrieveClientFromFingerprint(const FingerprintDigest& fingerprint);
 };
 
 #endif
\ No newline at end of file
@@ -11,7 +11,7 @@
 class ClientSignature{
     public:
         static std::string generateSignature(std::string message, EVP_PKEY * private_key, std::string counter);
-        static bool verifySignature(std::string encrypted_signature, std::string decrypted_message, EVP_PKEY* publicKey);
+        static bool verifySignature(const std::string& encrypted_signature, const std::string& decrypted_message, EVP_PKEY* publicKey);
 };
 
 #endif
\ No newline at end of file
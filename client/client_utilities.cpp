@@ -1,24 +1,8 @@
 #include "client_utilities.h"
 
 std::string ClientUtilities::get_ttd(){
-    // Generate current time
-    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
-
-    std::chrono::minutes minute(1);
-
-    // Add one minute
-    std::chrono::system_clock::time_point newTime = now + minute;
-
-    std::time_t convTime = std::chrono::system_clock::to_time_t(newTime);
-
-    // Convert to GMT time and time structure
-    std::tm* utc_tm = std::gmtime(&convTime);
-
-    // Convert to ISO 8601 structure
-    std::stringstream timeString;
-    timeString << std::put_time(utc_tm, "%Y-%m-%dT%H:%M:%SZ");
-    
-    return timeString.str();
+    // One minute from now, as an ISO 8601 timestamp
+    return UtcTime::format(UtcTime::now() + 60);
 }
 
 bool ClientUtilities::is_connection_open(websocket_endpoint* endpoint, int id){
@@ -42,9 +26,9 @@ void ClientUtilities::send_hello_message(websocket_endpoint* endpoint, int id, E
     endpoint->send(id, json_string, websocketpp::frame::opcode::text, ec);
 
     if (ec) {
-        std::cout << "> Error sending hello message: " << ec.message() << std::endl;
+        LOG_WARN("> Error sending hello message: " << ec.message());
     } else {
-        std::cout << "> Hello message sent" << std::endl;
+        LOG_INFO("> Hello message sent");
     }
 }
 
@@ -59,9 +43,9 @@ void ClientUtilities::send_client_list_request(websocket_endpoint* endpoint, int
     endpoint->send(id, json_string, websocketpp::frame::opcode::text, ec);
 
     if (ec) {
-        std::cout << "> Error sending client list request message: " << ec.message() << std::endl;
+        LOG_WARN("> Error sending client list request message: " << ec.message());
     } else {
-        std::cout << "> Client list request sent" << "\n" << std::endl;
+        LOG_INFO("> Client list request sent");
     }
 }
 
@@ -76,9 +60,9 @@ void ClientUtilities::send_public_chat(websocket_endpoint* endpoint, int id, std
     endpoint->send(id, json_string, websocketpp::frame::opcode::text, ec);
 
     if (ec) {
-        std::cout << "> Error sending public chat message: " << ec.message() << std::endl;
+        LOG_WARN("> Error sending public chat message: " << ec.message());
     } else {
-        std::cout << ">  Public chat message sent" << std::endl;
+        LOG_INFO(">  Public chat message sent");
     }
 }
 
@@ -93,8 +77,8 @@ void ClientUtilities::send_chat(websocket_endpoint* endpoint, int connection_id,
     endpoint->send(connection_id, json_string, websocketpp::frame::opcode::text, ec);
 
     if (ec) {
-        std::cout << "> Error sending chat message: " << ec.message() << std::endl;
+        LOG_WARN("> Error sending chat message: " << ec.message());
     } else {
-        std::cout << ">  Chat message sent" <<  std::endl;
+        LOG_INFO(">  Chat message sent");
     }
 }
\ No newline at end of file
@@ -18,6 +18,7 @@
 
 #include "MessageGenerator.h" // For creating messages to send
 #include "client_key_gen.h" // OpenSSL Key generation
+#include "utc_time.h" // Time-to-die timestamps
 
 
 class ClientUtilities{
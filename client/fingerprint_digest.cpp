@@ -0,0 +1,110 @@
+#include "fingerprint_digest.h"
+#include "base64.h"
+
+// Length of the base64 text of a 64 character hex digest
+static const size_t textLength = 88;
+
+static int base64Value(char c){
+    if(c >= 'A' && c <= 'Z') return c - 'A';
+    if(c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if(c >= '0' && c <= '9') return c - '0' + 52;
+    if(c == '+') return 62;
+    if(c == '/') return 63;
+    return -1;
+}
+
+static int hexValue(char c){
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+FingerprintDigest::FingerprintDigest(){
+    std::memset(bytes, 0, digestSize);
+    isValid = false;
+}
+
+bool FingerprintDigest::parseHex(const char* hex, size_t length, FingerprintDigest& digest){
+    if(length != digestSize * 2){
+        return false;
+    }
+    for(size_t i = 0; i < digestSize; i++){
+        int high = hexValue(hex[i * 2]);
+        int low = hexValue(hex[i * 2 + 1]);
+        if(high < 0 || low < 0){
+            return false;
+        }
+        digest.bytes[i] = (unsigned char)(high << 4 | low);
+    }
+    digest.isValid = true;
+    return true;
+}
+
+bool FingerprintDigest::fromText(const std::string& text, FingerprintDigest& digest){
+    digest = FingerprintDigest();
+    if(text.size() != textLength || text[textLength - 1] != '=' || text[textLength - 2] != '='){
+        return false;
+    }
+
+    // Decode the base64 text into the hex digest on the stack
+    char hex[digestSize * 2 + 2];
+    size_t length = 0;
+    for(size_t i = 0; i < textLength; i += 4){
+        int values[4];
+        int count = 0;
+        for(size_t j = 0; j < 4; j++){
+            if(text[i + j] == '='){
+                break;
+            }
+            values[j] = base64Value(text[i + j]);
+            if(values[j] < 0){
+                return false;
+            }
+            count++;
+        }
+        if(count < 2){
+            return false;
+        }
+        hex[length++] = (char)(values[0] << 2 | values[1] >> 4);
+        if(count > 2){
+            hex[length++] = (char)((values[1] & 0x0f) << 4 | values[2] >> 2);
+        }
+        if(count > 3){
+            hex[length++] = (char)((values[2] & 0x03) << 6 | values[3]);
+        }
+    }
+
+    if(!parseHex(hex, length, digest)){
+        digest = FingerprintDigest();
+        return false;
+    }
+    return true;
+}
+
+FingerprintDigest FingerprintDigest::fromText(const std::string& text){
+    FingerprintDigest digest;
+    fromText(text, digest);
+    return digest;
+}
+
+FingerprintDigest FingerprintDigest::fromHex(const std::string& hex){
+    FingerprintDigest digest;
+    if(!parseHex(hex.data(), hex.size(), digest)){
+        digest = FingerprintDigest();
+    }
+    return digest;
+}
+
+std::string FingerprintDigest::toText() const{
+    if(!isValid){
+        return "";
+    }
+    static const char hexChars[] = "0123456789abcdef";
+    std::string hex(digestSize * 2, '0');
+    for(size_t i = 0; i < digestSize; i++){
+        hex[i * 2] = hexChars[bytes[i] >> 4];
+        hex[i * 2 + 1] = hexChars[bytes[i] & 0x0f];
+    }
+    return Base64::encode(hex);
+}
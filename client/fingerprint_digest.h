@@ -0,0 +1,57 @@
+#ifndef FINGERPRINT_DIGEST_H
+#define FINGERPRINT_DIGEST_H
+#include <string>
+#include <cstring>
+#include <cstddef>
+
+/*
+    A fingerprint held as the 32 byte SHA-256 digest of a key's PEM string.
+
+    Fingerprints are sent in messages as text (base64 of the hex digest, see Fingerprint.h), 88 characters on the
+    heap. FingerprintDigest keeps just the digest inline and is trivially copyable, so maps keyed on it never allocate
+    and never hash the whole text. The digest is already uniformly distributed, so its hash is its first few bytes.
+
+    Convert from the text once when a message arrives with fromText(), and back with toText() when sending.
+*/
+class FingerprintDigest{
+    public:
+        static const size_t digestSize = 32;
+
+        // Invalid until parsed
+        FingerprintDigest();
+
+        // Parses the text of a fingerprint, returns false (leaving digest invalid) if it isn't one. Doesn't allocate.
+        static bool fromText(const std::string& text, FingerprintDigest& digest);
+        static FingerprintDigest fromText(const std::string& text);
+
+        // Parses a hex SHA-256 digest, as returned by Sha256Hash::hashStringSha256
+        static FingerprintDigest fromHex(const std::string& hex);
+
+        // Text of the fingerprint as sent in messages, empty if invalid
+        std::string toText() const;
+
+        bool valid() const { return isValid; }
+        const unsigned char* data() const { return bytes; }
+
+        bool operator==(const FingerprintDigest& other) const {
+            return isValid == other.isValid && std::memcmp(bytes, other.bytes, digestSize) == 0;
+        }
+        bool operator!=(const FingerprintDigest& other) const { return !(*this == other); }
+
+        // For unordered maps keyed on fingerprints
+        struct Hash{
+            size_t operator()(const FingerprintDigest& digest) const {
+                size_t hash;
+                std::memcpy(&hash, digest.bytes, sizeof(hash));
+                return hash;
+            }
+        };
+
+    private:
+        unsigned char bytes[digestSize];
+        bool isValid;
+
+        static bool parseHex(const char* hex, size_t length, FingerprintDigest& digest);
+};
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+#include <vector>
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+/*
+    Hash map with open addressing, shared by the client and server for their directories and connection tables.
+
+    Entries are kept in one contiguous array and never move, so a map needs no allocation per entry, iterating it
+    walks memory in order, and an entry's Handle (its index in the array) stays valid until that entry is erased.
+    Lookups probe a separate table of entry indices (linear probing, at most half full), comparing the stored hash of
+    each entry before its key. Erased entries are reused by later insertions.
+
+    Supports the parts of std::unordered_map the code uses: find, operator[], erase (by key or iterator), iteration
+    over std::pair<Key, Value>, size, clear and reserve. Unlike std::unordered_map, inserting may invalidate
+    iterators and references (but never handles), and keys are hashed once when inserted and never again.
+*/
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class FlatMap{
+    public:
+        typedef std::pair<Key, Value> value_type;
+        typedef uint32_t Handle;
+        static const Handle npos = 0xffffffff;
+
+    private:
+        struct Entry{
+            value_type value;
+            uint32_t hash = 0; // Low 32 bits of the key's hash, all the table needs
+            bool live = false;
+        };
+
+        std::vector<Entry> entries;
+        std::vector<Handle> freeEntries; // Erased entries to reuse
+        std::vector<Handle> table; // Entry indices, npos if empty, size is a power of two
+        size_t entryCount = 0;
+        int shift = 64; // 64 - log2(table.size())
+        Hash hasher;
+        Equal equal;
+
+        // Fibonacci hashing, spreads sequential keys (e.g. client IDs) across the table
+        size_t home(uint32_t hash) const {
+            return (size_t)(((uint64_t)hash * 0x9E3779B97F4A7C15ull) >> shift);
+        }
+
+        // Returns the table position of a key, or npos if it isn't in the map
+        size_t position(const Key& key, uint32_t hash) const {
+            if(table.empty()){
+                return npos;
+            }
+            size_t mask = table.size() - 1;
+            for(size_t i = home(hash); table[i] != npos; i = (i + 1) & mask){
+                const Entry& entry = entries[table[i]];
+                if(entry.hash == hash && equal(entry.value.first, key)){
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        void rehash(size_t slots){
+            table.assign(slots, npos);
+            shift = 64;
+            for(size_t size = slots; size > 1; size >>= 1){
+                shift--;
+            }
+            size_t mask = slots - 1;
+            for(Handle e = 0; e < entries.size(); e++){
+                if(!entries[e].live){
+                    continue;
+                }
+                size_t i = home(entries[e].hash);
+                while(table[i] != npos){
+                    i = (i + 1) & mask;
+                }
+                table[i] = e;
+            }
+        }
+
+        Handle insertNew(const Key& key, uint32_t hash){
+            if((entryCount + 1) * 2 > table.size()){
+                rehash(table.empty() ? 16 : table.size() * 2);
+            }
+
+            Handle e;
+            if(!freeEntries.empty()){
+                e = freeEntries.back();
+                freeEntries.pop_back();
+            }else{
+                e = (Handle)entries.size();
+                entries.emplace_back();
+            }
+            entries[e].value.first = key;
+            entries[e].hash = hash;
+            entries[e].live = true;
+
+            size_t mask = table.size() - 1;
+            size_t i = home(hash);
+            while(table[i] != npos){
+                i = (i + 1) & mask;
+            }
+            table[i] = e;
+            entryCount++;
+            return e;
+        }
+
+        // Removes the entry at a table position, shifting back entries that probed past it
+        void eraseAt(size_t i){
+            Handle e = table[i];
+            size_t mask = table.size() - 1;
+            for(size_t j = (i + 1) & mask; table[j] != npos; j = (j + 1) & mask){
+                size_t distance = (j - home(entries[table[j]].hash)) & mask;
+                if(distance >= ((j - i) & mask)){
+                    table[i] = table[j];
+                    i = j;
+                }
+            }
+            table[i] = npos;
+
+            // Release whatever the entry held straight away
+            entries[e].value = value_type();
+            entries[e].live = false;
+            freeEntries.push_back(e);
+            entryCount--;
+        }
+
+        template<bool Const>
+        class Iterator{
+            friend class FlatMap;
+            typedef typename std::conditional<Const, const FlatMap, FlatMap>::type map_type;
+            map_type* map;
+            Handle index;
+
+            void skipDead(){
+                while(index < map->entries.size() && !map->entries[index].live){
+                    index++;
+                }
+            }
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef typename FlatMap::value_type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef typename std::conditional<Const, const value_type*, value_type*>::type pointer;
+            typedef typename std::conditional<Const, const value_type&, value_type&>::type reference;
+
+            Iterator() : map(nullptr), index(0) {}
+            Iterator(map_type* m, Handle i) : map(m), index(i) { skipDead(); }
+            // Iterators convert to const iterators
+            template<bool OtherConst, typename = typename std::enable_if<Const && !OtherConst>::type>
+            Iterator(const Iterator<OtherConst>& other) : map(other.map), index(other.index) {}
+
+            reference operator*() const { return map->entries[index].value; }
+            pointer operator->() const { return &map->entries[index].value; }
+            Iterator& operator++(){ index++; skipDead(); return *this; }
+            Iterator operator++(int){ Iterator previous = *this; ++(*this); return previous; }
+            bool operator==(const Iterator& other) const { return index == other.index; }
+            bool operator!=(const Iterator& other) const { return index != other.index; }
+
+            Handle handle() const { return index; }
+
+            template<bool> friend class Iterator;
+        };
+
+    public:
+        typedef Iterator<false> iterator;
+        typedef Iterator<true> const_iterator;
+
+        iterator begin(){ return iterator(this, 0); }
+        iterator end(){ return iterator(this, (Handle)entries.size()); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, (Handle)entries.size()); }
+
+        size_t size() const { return entryCount; }
+        bool empty() const { return entryCount == 0; }
+
+        void clear(){
+            entries.clear();
+            freeEntries.clear();
+            table.clear();
+            entryCount = 0;
+            shift = 64;
+        }
+
+        // Makes room for entries without rehashing
+        void reserve(size_t size){
+            entries.reserve(size);
+            size_t slots = 16;
+            while(slots < size * 2){
+                slots *= 2;
+            }
+            if(slots > table.size()){
+                rehash(slots);
+            }
+        }
+
+        iterator find(const Key& key){
+            size_t i = position(key, (uint32_t)hasher(key));
+            return i == npos ? end() : iterator(this, table[i]);
+        }
+        const_iterator find(const Key& key) const {
+            size_t i = position(key, (uint32_t)hasher(key));
+            return i == npos ? end() : const_iterator(this, table[i]);
+        }
+
+        size_t count(const Key& key) const {
+            return position(key, (uint32_t)hasher(key)) == npos ? 0 : 1;
+        }
+
+        Value& operator[](const Key& key){
+            uint32_t hash = (uint32_t)hasher(key);
+            size_t i = position(key, hash);
+            if(i != npos){
+                return entries[table[i]].value.second;
+            }
+            return entries[insertNew(key, hash)].value.second;
+        }
+
+        // Inserts the entry if the key isn't already in the map, returns the key's entry and whether it was inserted
+        std::pair<iterator, bool> insert(const value_type& value){
+            uint32_t hash = (uint32_t)hasher(value.first);
+            size_t i = position(value.first, hash);
+            if(i != npos){
+                return std::make_pair(iterator(this, table[i]), false);
+            }
+            Handle e = insertNew(value.first, hash);
+            entries[e].value.second = value.second;
+            return std::make_pair(iterator(this, e), true);
+        }
+
+        // Returns the handle of a key's entry, or npos if it isn't in the map
+        Handle handle(const Key& key) const {
+            size_t i = position(key, (uint32_t)hasher(key));
+            return i == npos ? npos : table[i];
+        }
+
+        // Entry for a handle, the handle must belong to an entry that hasn't been erased
+        value_type& at(Handle handle){ return entries[handle].value; }
+        const value_type& at(Handle handle) const { return entries[handle].value; }
+
+        size_t erase(const Key& key){
+            size_t i = position(key, (uint32_t)hasher(key));
+            if(i == npos){
+                return 0;
+            }
+            eraseAt(i);
+            return 1;
+        }
+
+        // Returns the iterator after the erased entry, no other entries move
+        iterator erase(const_iterator it){
+            // Find the entry's table position from its stored hash, the key isn't compared or hashed again
+            Handle e = it.index;
+            size_t mask = table.size() - 1;
+            for(size_t i = home(entries[e].hash); table[i] != npos; i = (i + 1) & mask){
+                if(table[i] == e){
+                    eraseAt(i);
+                    break;
+                }
+            }
+            return iterator(this, e + 1);
+        }
+        iterator erase(iterator it){
+            return erase(const_iterator(it));
+        }
+
+        // Bytes used by the map itself, not counting anything its keys or values allocate
+        size_t memoryUsage() const {
+            return entries.capacity() * sizeof(Entry) + table.capacity() * sizeof(Handle) + freeEntries.capacity() * sizeof(Handle);
+        }
+};
+
+template<typename Key, typename Value, typename Hash, typename Equal>
+const typename FlatMap<Key, Value, Hash, Equal>::Handle FlatMap<Key, Value, Hash, Equal>::npos;
+
+#endif
@@ -0,0 +1,151 @@
+#include "key_cache.h"
+#include "Fingerprint.h"
+
+std::mutex KeyCache::cacheMutex;
+std::unordered_map<const std::string*, KeyCache::Entry> KeyCache::entries;
+std::unordered_map<EVP_PKEY*, KeyCache::Entry*> KeyCache::entryByKey;
+size_t KeyCache::unowned = 0;
+
+// Finds the entry for an interned PEM string, parsing the key and creating an entry if it is not cached
+KeyCache::Entry* KeyCache::find(const KeyPool::Key& pem){
+    auto found = entries.find(pem.get());
+    if(found != entries.end()){
+        return &found->second;
+    }
+
+    BIO* bio = BIO_new_mem_buf(pem->data(), (int)pem->size()); // Create a BIO for the key string
+    if(!bio){
+        return nullptr;
+    }
+    EVP_PKEY* key = PEM_read_bio_PUBKEY(bio, NULL, NULL, NULL); // Read PEM public key
+    BIO_free(bio); // Free the BIO after use
+
+    if(!key){
+        std::cerr << "Error loading public key from string." << std::endl;
+        return nullptr;
+    }
+
+    // Too many keys nobody has claimed, drop them before adding another
+    if(unowned >= maxUnowned){
+        sweepUnowned();
+    }
+
+    Entry& entry = entries[pem.get()];
+    entry.pem = pem;
+    entry.key = Handle(key, EVP_PKEY_free);
+    entryByKey[key] = &entry;
+    unowned++;
+
+    return &entry;
+}
+
+// Evicts every key that has no owners, handles already given out remain valid
+void KeyCache::sweepUnowned(){
+    for(auto entry = entries.begin(); entry != entries.end();){
+        if(entry->second.owners <= 0){
+            entryByKey.erase(entry->second.key.get());
+            entry = entries.erase(entry);
+        }else{
+            entry++;
+        }
+    }
+    unowned = 0;
+}
+
+const std::string& KeyCache::entryFingerprint(Entry& entry){
+    if(entry.fingerprint.empty()){
+        entry.fingerprint = Fingerprint::generateFingerprint(entry.key.get());
+        entry.digest = FingerprintDigest::fromText(entry.fingerprint);
+    }
+    return entry.fingerprint;
+}
+
+KeyCache::Handle KeyCache::get(const std::string& pem){
+    KeyPool::Key interned = KeyPool::intern(pem);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    Entry* entry = find(interned);
+    if(!entry){
+        return Handle();
+    }
+    return entry->key;
+}
+
+KeyCache::Handle KeyCache::acquire(const std::string& pem){
+    KeyPool::Key interned = KeyPool::intern(pem);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    Entry* entry = find(interned);
+    if(!entry){
+        return Handle();
+    }
+    if(entry->owners == 0){
+        unowned--;
+    }
+    entry->owners++;
+    return entry->key;
+}
+
+void KeyCache::release(const std::string& pem){
+    KeyPool::Key interned = KeyPool::intern(pem);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto found = entries.find(interned.get());
+    if(found == entries.end() || found->second.owners <= 0){
+        return;
+    }
+    found->second.owners--;
+
+    // Last owner released the key, handles already given out remain valid
+    if(found->second.owners == 0){
+        entryByKey.erase(found->second.key.get());
+        entries.erase(found);
+    }
+}
+
+std::string KeyCache::fingerprint(const std::string& pem){
+    KeyPool::Key interned = KeyPool::intern(pem);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    Entry* entry = find(interned);
+    if(!entry){
+        return "";
+    }
+    return entryFingerprint(*entry);
+}
+
+std::string KeyCache::fingerprint(EVP_PKEY* key){
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = entryByKey.find(key);
+        if(found != entryByKey.end()){
+            return entryFingerprint(*found->second);
+        }
+    }
+    // Key is not owned by the cache, so its pointer may not stay valid and it cannot be cached
+    return Fingerprint::generateFingerprint(key);
+}
+
+FingerprintDigest KeyCache::digest(const std::string& pem){
+    KeyPool::Key interned = KeyPool::intern(pem);
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    Entry* entry = find(interned);
+    if(!entry){
+        return FingerprintDigest();
+    }
+    entryFingerprint(*entry);
+    return entry->digest;
+}
+
+FingerprintDigest KeyCache::digest(EVP_PKEY* key){
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto found = entryByKey.find(key);
+        if(found != entryByKey.end()){
+            entryFingerprint(*found->second);
+            return found->second->digest;
+        }
+    }
+    return FingerprintDigest::fromText(Fingerprint::generateFingerprint(key));
+}
+
+size_t KeyCache::size(){
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    return entries.size();
+}
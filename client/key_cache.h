@@ -0,0 +1,83 @@
+#ifndef KEY_CACHE_H
+#define KEY_CACHE_H
+#include <string>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+
+#include "fingerprint_digest.h"
+#include "key_pool.h"
+
+/*
+    Process wide cache of parsed public keys, shared by the client and server.
+
+    Keys are stored against their PEM string, so a key is only parsed (and fingerprinted) once no matter how many
+    messages it is used for. The PEM string is interned in the KeyPool, so the cache shares the one copy of it that
+    ServerList and ClientList hold rather than keeping its own. Handles are reference counted, a key is only freed once it has been evicted from the
+    cache and every caller holding a handle has dropped it.
+
+    Owners (ServerList, ClientList) call acquire() when they start storing a key and release() when the client is
+    removed, the key is evicted when its last owner releases it. Keys looked up with get() that are never acquired
+    (e.g. a hello that failed verification) are swept once there are too many of them.
+*/
+class KeyCache{
+    public:
+        typedef std::shared_ptr<EVP_PKEY> Handle;
+
+        /*
+            Returns the parsed key for a PEM string, parsing and caching it if it has not been seen before.
+            Returns an empty handle if the PEM string could not be parsed.
+        */
+        static Handle get(const std::string& pem);
+
+        // Same as get() but also registers an owner, so the key stays cached until release() is called
+        static Handle acquire(const std::string& pem);
+
+        // Removes an owner of the key, evicting it once no owners are left
+        static void release(const std::string& pem);
+
+        /*
+            Returns the fingerprint of a PEM string, computed once and cached alongside the key.
+            Returns an empty string if the PEM string could not be parsed.
+        */
+        static std::string fingerprint(const std::string& pem);
+
+        /*
+            Returns the fingerprint of a key, using the cached fingerprint if the key came from this cache.
+            Keys not from the cache are fingerprinted directly.
+        */
+        static std::string fingerprint(EVP_PKEY* key);
+
+        // Same as fingerprint() but returns the fingerprint's digest, for looking the key up in maps keyed on it
+        static FingerprintDigest digest(const std::string& pem);
+        static FingerprintDigest digest(EVP_PKEY* key);
+
+        // Number of keys currently cached
+        static size_t size();
+
+    private:
+        struct Entry{
+            KeyPool::Key pem; // Keeps the interned PEM string, and so the pointer the entry is stored against, alive
+            Handle key;
+            std::string fingerprint;
+            FingerprintDigest digest;
+            int owners = 0;
+        };
+
+        // Maximum number of cached keys with no owners before they are swept
+        static const size_t maxUnowned = 256;
+
+        static std::mutex cacheMutex;
+        static std::unordered_map<const std::string*, Entry> entries; // Entries stored against their interned PEM string
+        static std::unordered_map<EVP_PKEY*, Entry*> entryByKey; // Entries stored against their parsed key
+        static size_t unowned;
+
+        static Entry* find(const KeyPool::Key& pem);
+        static void sweepUnowned();
+        static const std::string& entryFingerprint(Entry& entry);
+};
+
+#endif
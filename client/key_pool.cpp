@@ -0,0 +1,80 @@
+#include "key_pool.h"
+
+std::unordered_multimap<size_t, std::weak_ptr<const std::string>> KeyPool::keys;
+std::mutex KeyPool::poolMutex;
+size_t KeyPool::sweepAt = 256;
+
+KeyPool::Key KeyPool::intern(const std::string& pem){
+    size_t hash = std::hash<std::string>()(pem);
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    auto range = keys.equal_range(hash);
+    for(auto found = range.first; found != range.second; found++){
+        Key key = found->second.lock();
+        if(key && *key == pem){
+            return key;
+        }
+    }
+
+    // Freed keys are left in the table until it has grown enough to be worth sweeping
+    if(keys.size() >= sweepAt){
+        sweep();
+    }
+
+    Key key = std::make_shared<const std::string>(pem);
+    keys.emplace(hash, key);
+    return key;
+}
+
+// Removes keys every reference has been dropped for
+void KeyPool::sweep(){
+    for(auto key = keys.begin(); key != keys.end();){
+        if(key->second.expired()){
+            key = keys.erase(key);
+        }else{
+            key++;
+        }
+    }
+
+    // Sweep again once the table has doubled, so interning stays constant time on average
+    sweepAt = keys.size() * 2 > 256 ? keys.size() * 2 : 256;
+}
+
+size_t KeyPool::size(){
+    std::lock_guard<std::mutex> lock(poolMutex);
+    size_t live = 0;
+    for(const auto& key: keys){
+        if(!key.second.expired()){
+            live++;
+        }
+    }
+    return live;
+}
+
+size_t KeyPool::bytesStored(){
+    std::lock_guard<std::mutex> lock(poolMutex);
+    size_t stored = 0;
+    for(const auto& entry: keys){
+        Key key = entry.second.lock();
+        if(key){
+            stored += key->size();
+        }
+    }
+    return stored;
+}
+
+size_t KeyPool::bytesSaved(){
+    std::lock_guard<std::mutex> lock(poolMutex);
+    size_t saved = 0;
+    for(const auto& entry: keys){
+        Key key = entry.second.lock();
+        if(key){
+            // Less the reference just taken and the one copy that is stored
+            long references = key.use_count() - 1;
+            if(references > 1){
+                saved += (references - 1) * key->size();
+            }
+        }
+    }
+    return saved;
+}
@@ -0,0 +1,43 @@
+#ifndef KEY_POOL_H
+#define KEY_POOL_H
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/*
+    Process wide table of interned public key PEM strings, shared by the client and server.
+
+    A PEM string is around 450 bytes, and the same key is stored in several maps (ServerList keeps it against the
+    client ID, the fingerprint, the connected clients and the known clients). Interning stores each distinct key once
+    and the maps hold a Key, a reference counted pointer to the stored string, instead of their own copy.
+
+    A key is freed once every Key referring to it has been dropped. The table itself only holds weak references,
+    which are swept once enough keys have been freed.
+*/
+class KeyPool{
+    public:
+        typedef std::shared_ptr<const std::string> Key;
+
+        // Returns the interned copy of a PEM string, storing it if it has not been seen before
+        static Key intern(const std::string& pem);
+
+        // Number of distinct keys currently stored
+        static size_t size();
+
+        // Bytes of PEM strings currently stored, each distinct key counted once
+        static size_t bytesStored();
+
+        // Bytes that would have been stored if every reference to a key held its own copy, less bytesStored()
+        static size_t bytesSaved();
+
+    private:
+        // Keys stored against the hash of their PEM string, so the table doesn't keep a copy of every string as well
+        static std::unordered_multimap<size_t, std::weak_ptr<const std::string>> keys;
+        static std::mutex poolMutex;
+        static size_t sweepAt; // Table size the next sweep of freed keys happens at
+
+        static void sweep();
+};
+
+#endif
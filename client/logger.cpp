@@ -0,0 +1,240 @@
+#include "logger.h"
+
+#include <iostream>
+#include <chrono>
+
+#ifdef LOG_ENABLE_DEBUG
+std::atomic<int> Logger::minimumLevel(Logger::Debug);
+#else
+std::atomic<int> Logger::minimumLevel(Logger::Info);
+#endif
+std::atomic<bool> Logger::logPayloads(false);
+
+namespace {
+
+/*
+    Bounded multi-producer ring buffer of log lines, read by the one running LogWriter.
+    Each slot's sequence says whether it is free to write (sequence == position) or holds a line to read
+    (sequence == position + 1), so producers only contend on claiming a position and never lock.
+*/
+class LogRing{
+    public:
+        static const size_t capacity = 8192; // Power of two
+
+        LogRing(){
+            for(size_t i = 0; i < capacity; i++){
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Moves the line into the ring, leaving text with a spare string. Returns false if the ring is full.
+        bool push(Logger::Level level, std::string& text){
+            size_t position = tail.load(std::memory_order_relaxed);
+            Slot* slot;
+            while(true){
+                slot = &slots[position & (capacity - 1)];
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                long long difference = (long long)sequence - (long long)position;
+                if(difference == 0){
+                    if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                        break;
+                    }
+                }else if(difference < 0){
+                    return false;
+                }else{
+                    position = tail.load(std::memory_order_relaxed);
+                }
+            }
+            slot->level = level;
+            slot->text.swap(text);
+            slot->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Appends the next line to out, only called by the writer. Returns false if the ring is empty.
+        bool pop(Logger::Level& level, std::string& out){
+            Slot& slot = slots[head & (capacity - 1)];
+            if(slot.sequence.load(std::memory_order_acquire) != head + 1){
+                return false;
+            }
+            level = slot.level;
+            out.append(slot.text);
+            out.push_back('\n');
+            slot.text.clear();
+            slot.sequence.store(head + capacity, std::memory_order_release);
+            head++;
+            return true;
+        }
+
+        bool empty() const {
+            return slots[head & (capacity - 1)].sequence.load(std::memory_order_acquire) != head + 1;
+        }
+
+    private:
+        struct Slot{
+            std::atomic<size_t> sequence;
+            Logger::Level level = Logger::Info;
+            std::string text;
+        };
+
+        Slot slots[capacity];
+        std::atomic<size_t> tail{0};
+        size_t head = 0; // Only used by the writer
+};
+
+LogRing& ring(){
+    static LogRing lines;
+    return lines;
+}
+
+std::atomic<bool> writerRunning(false);
+std::atomic<bool> writerSleeping(false);
+std::atomic<size_t> droppedLines(0);
+std::atomic<size_t> droppedTotal(0);
+std::atomic<int> pushing(0); // Producers that may be queueing a line, the writer doesn't stop until there are none
+std::mutex wakeMutex;
+std::condition_variable wake;
+bool stopping = false;
+
+std::mutex directMutex;
+
+// Writes a batch of lines to the stream for their level with a single write
+void flushBatch(std::string& batch, bool toError){
+    if(batch.empty()){
+        return;
+    }
+    // Lines written straight away while the writer is stopping go to the same streams
+    std::lock_guard<std::mutex> lock(directMutex);
+    std::ostream& out = toError ? std::cerr : std::cout;
+    out.write(batch.data(), batch.size());
+    out.flush();
+    batch.clear();
+}
+
+}
+
+void Logger::setLevel(Level level){
+    minimumLevel.store(level, std::memory_order_relaxed);
+}
+
+void Logger::setPayloads(bool enabled){
+    logPayloads.store(enabled, std::memory_order_relaxed);
+}
+
+std::ostringstream& Logger::stream(){
+    static thread_local std::ostringstream line;
+    return line;
+}
+
+void Logger::write(Level level, std::ostringstream& line){
+    std::string text = line.str();
+    line.str(std::string());
+    line.clear();
+
+    // Counted before checking the writer is running, so a line queued as the writer is stopping is still written
+    pushing.fetch_add(1);
+    if(!writerRunning.load()){
+        pushing.fetch_sub(1);
+        writeNow(level, text);
+        return;
+    }
+    if(!ring().push(level, text)){
+        droppedLines.fetch_add(1, std::memory_order_relaxed);
+        pushing.fetch_sub(1);
+        return;
+    }
+    pushing.fetch_sub(1);
+
+    // Only wake the writer if it has run out of lines, a busy writer picks the line up on its next pass
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(writerSleeping.load(std::memory_order_relaxed)){
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        writerSleeping.store(false, std::memory_order_relaxed);
+        wake.notify_one();
+    }
+}
+
+size_t Logger::dropped(){
+    return droppedTotal.load(std::memory_order_relaxed) + droppedLines.load(std::memory_order_relaxed);
+}
+
+void Logger::writeNow(Level level, const std::string& text){
+    std::lock_guard<std::mutex> lock(directMutex);
+    (level >= Warn ? std::cerr : std::cout) << text << std::endl;
+}
+
+LogWriter::LogWriter(){
+    bool running = false;
+    if(!writerRunning.compare_exchange_strong(running, true)){
+        return;
+    }
+    owner = true;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = false;
+    }
+    writer = std::thread(&LogWriter::run, this);
+}
+
+LogWriter::~LogWriter(){
+    if(!owner){
+        return;
+    }
+    // New lines are written straight away from here, the thread writes the ones already queued before it stops.
+    // Wait for producers that saw the writer running to finish queueing, so the thread's last pass sees their lines.
+    writerRunning.store(false);
+    while(pushing.load() > 0){
+        std::this_thread::yield();
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+void LogWriter::run(){
+    LogRing& lines = ring();
+    std::string batch;
+    bool batchToError = false;
+
+    while(true){
+        // Write every queued line, one write per run of lines going to the same stream
+        Logger::Level level;
+        std::string line;
+        while(lines.pop(level, line)){
+            bool toError = level >= Logger::Warn;
+            if(toError != batchToError){
+                flushBatch(batch, batchToError);
+                batchToError = toError;
+            }
+            batch.append(line);
+            line.clear();
+        }
+        flushBatch(batch, batchToError);
+
+        size_t dropped = droppedLines.exchange(0, std::memory_order_relaxed);
+        if(dropped > 0){
+            droppedTotal.fetch_add(dropped, std::memory_order_relaxed);
+            Logger::writeNow(Logger::Warn, std::to_string(dropped) + " log lines dropped, the log buffer was full");
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if(stopping){
+            if(lines.empty()){
+                break;
+            }
+            continue;
+        }
+        writerSleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(!lines.empty()){
+            writerSleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        // The timeout only matters if a wake up is missed, producers wake the writer when they queue a line
+        wake.wait_for(lock, std::chrono::milliseconds(50), []{ return stopping || !writerSleeping.load(std::memory_order_relaxed); });
+        writerSleeping.store(false, std::memory_order_relaxed);
+    }
+}
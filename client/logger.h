@@ -0,0 +1,101 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*
+    Leveled logging shared by the client and server, used through the LOG_ macros:
+
+        LOG_INFO("Sent client list to client " << client_id);
+
+    Each call is one line. Lines are queued on a lock-free ring buffer and written by a LogWriter's thread in batches,
+    one write (and flush) per batch rather than one per line, so logging never waits on the terminal or log file.
+    Debug and Info lines go to stdout, Warn and Error lines to stderr, each as the bare message. Lines are written
+    straight away (as std::cout/std::cerr with std::endl did) when no LogWriter is running, e.g. in the tests.
+
+    LOG_DEBUG lines are compiled out unless built with -DLOG_ENABLE_DEBUG, so per-message tracing costs nothing in a
+    normal build. Lines below the level set with setLevel() (Info by default, Debug when built with
+    -DLOG_ENABLE_DEBUG) are skipped before they are formatted.
+    LOG_PAYLOAD lines log whole messages and are skipped unless setPayloads(true) is called.
+
+    If the ring buffer is full the line is dropped and counted rather than waiting, the count is logged once there is room.
+*/
+class Logger{
+    public:
+        enum Level{ Debug = 0, Info = 1, Warn = 2, Error = 3 };
+
+        static bool enabled(Level level){
+            return level >= minimumLevel.load(std::memory_order_relaxed);
+        }
+        static bool payloads(){
+            return logPayloads.load(std::memory_order_relaxed);
+        }
+
+        static void setLevel(Level level);
+        static void setPayloads(bool enabled);
+
+        // Stream for formatting a line on the calling thread, cleared for each line
+        static std::ostringstream& stream();
+
+        // Logs the line formatted in stream()
+        static void write(Level level, std::ostringstream& line);
+
+        // Lines dropped because the ring buffer was full
+        static size_t dropped();
+
+    private:
+        friend class LogWriter;
+
+        static std::atomic<int> minimumLevel;
+        static std::atomic<bool> logPayloads;
+
+        static void writeNow(Level level, const std::string& text);
+};
+
+/*
+    Writes queued log lines on its own thread, from construction until it is destroyed (writing any lines still
+    queued first). Only one writer runs at a time, a LogWriter created while another is running does nothing.
+*/
+class LogWriter{
+    private:
+        std::thread writer;
+        bool owner = false;
+
+        void run();
+    public:
+        LogWriter();
+        ~LogWriter();
+};
+
+#define LOG_AT(level, message) \
+    do{ \
+        if(Logger::enabled(level)){ \
+            std::ostringstream& log_line = Logger::stream(); \
+            log_line << message; \
+            Logger::write(level, log_line); \
+        } \
+    }while(0)
+
+#ifdef LOG_ENABLE_DEBUG
+#define LOG_DEBUG(message) LOG_AT(Logger::Debug, message)
+#else
+#define LOG_DEBUG(message) do{}while(0)
+#endif
+
+#define LOG_INFO(message) LOG_AT(Logger::Info, message)
+#define LOG_WARN(message) LOG_AT(Logger::Warn, message)
+#define LOG_ERROR(message) LOG_AT(Logger::Error, message)
+
+#define LOG_PAYLOAD(message) \
+    do{ \
+        if(Logger::payloads()){ \
+            LOG_AT(Logger::Info, message); \
+        } \
+    }while(0)
+
+#endif
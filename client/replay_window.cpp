@@ -0,0 +1,69 @@
+#include "replay_window.h"
+
+#include <algorithm>
+#include <random>
+
+ReplayWindow::ReplayWindow(size_t max_senders) : droppedHighest(droppedSlots, 0){
+    maxSenders = max_senders > 0 ? max_senders : 1;
+    std::random_device random;
+    salt = ((uint64_t)random() << 32) | random();
+}
+
+size_t ReplayWindow::droppedSlot(const FingerprintDigest& sender) const{
+    // Mixed with the salt so the slot can't be predicted from the sender's fingerprint
+    uint64_t hash = (FingerprintDigest::Hash()(sender) ^ salt) * 0x9E3779B97F4A7C15ull;
+    return (size_t)(hash >> 32) & (droppedSlots - 1);
+}
+
+bool ReplayWindow::check(const FingerprintDigest& sender, int counter){
+    std::lock_guard<std::mutex> lock(windowMutex);
+
+    auto found = windows.find(sender);
+    if(found == windows.end()){
+        // Drop the least recently seen sender to make room, keeping its highest counter
+        if(windows.size() >= maxSenders){
+            auto dropped = windows.find(recentSenders.back());
+            int64_t& highest = droppedHighest[droppedSlot(dropped->first)];
+            highest = std::max(highest, dropped->second.highest);
+            windows.erase(dropped);
+            recentSenders.pop_back();
+        }
+        recentSenders.push_front(sender);
+        found = windows.emplace(sender, Window()).first;
+        found->second.recent = recentSenders.begin();
+
+        // Every counter up to the highest of a dropped sender in the same slot counts as seen
+        found->second.highest = droppedHighest[droppedSlot(sender)];
+    }else{
+        recentSenders.splice(recentSenders.begin(), recentSenders, found->second.recent);
+    }
+
+    Window& window = found->second;
+
+    // Newer than anything seen, slide the window forward
+    if(counter > window.highest){
+        int64_t shift = counter - window.highest;
+        window.seen = shift >= windowSize ? 0 : window.seen << shift;
+        window.seen |= 1;
+        window.highest = counter;
+        return true;
+    }
+
+    // Too old to know if it has been seen
+    int64_t offset = window.highest - counter;
+    if(offset >= windowSize){
+        return false;
+    }
+
+    uint64_t bit = (uint64_t)1 << offset;
+    if(window.seen & bit){
+        return false;
+    }
+    window.seen |= bit;
+    return true;
+}
+
+size_t ReplayWindow::size(){
+    std::lock_guard<std::mutex> lock(windowMutex);
+    return windows.size();
+}
@@ -0,0 +1,67 @@
+#ifndef REPLAY_WINDOW_H
+#define REPLAY_WINDOW_H
+#include <string>
+#include <list>
+#include <mutex>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "fingerprint_digest.h"
+
+/*
+    Replay protection for signed messages, shared by the client and server.
+
+    Counters are tracked per sender fingerprint digest with a fixed size sliding window: a counter is accepted if it is newer
+    than the highest counter seen from the sender, or if it is within windowSize of it and has not been seen before.
+    This accepts messages that arrive slightly out of order (e.g. from different servers) while rejecting repeats.
+
+    Clients start their counter from the clock each time they run, so a sender's counters keep rising across reconnects
+    and restarts. Counters are never forgotten, so a message captured from an earlier session is rejected too.
+
+    Each sender uses a fixed amount of memory. Once maxSenders are tracked the least recently used sender's window is
+    dropped, but its highest counter is kept in a fixed size table indexed by a salted hash of the sender. A sender that
+    is seen again starts from the highest counter in its slot, so counters from before it was dropped are still
+    rejected. Senders sharing a slot share the highest of their counters, which can only reject counters, never accept
+    a replay.
+*/
+class ReplayWindow{
+    public:
+        // Number of counters below the highest counter that are still accepted
+        static const int windowSize = 64;
+
+        // size_t max_senders - Maximum number of senders tracked at once
+        ReplayWindow(size_t max_senders = 4096);
+
+        /*
+            Returns true and records the counter if it has not been seen from the sender, returns false if the message
+            is a replay or is too old to tell.
+            A sender that has never been seen starts with every counter up to 0 seen, so their first counter must be greater than 0.
+        */
+        bool check(const FingerprintDigest& sender, int counter);
+
+        // Number of senders currently tracked
+        size_t size();
+
+    private:
+        struct Window{
+            int64_t highest = 0; // Highest counter seen
+            uint64_t seen = ~(uint64_t)0; // Bit n is set if counter highest - n has been seen, counters up to the first one count as seen
+            std::list<FingerprintDigest>::iterator recent; // Position in recentSenders
+        };
+
+        // Number of slots in the table of highest counters of dropped senders, a power of two
+        static const size_t droppedSlots = 16384;
+
+        size_t maxSenders;
+        uint64_t salt; // Random per window, so senders can't choose keys that share a slot with another sender
+        std::vector<int64_t> droppedHighest; // Highest counter of the senders dropped into each slot
+
+        size_t droppedSlot(const FingerprintDigest& sender) const;
+
+        std::mutex windowMutex;
+        std::unordered_map<FingerprintDigest, Window, FingerprintDigest::Hash> windows; // Windows stored against sender fingerprint
+        std::list<FingerprintDigest> recentSenders; // Senders ordered from most to least recently seen
+};
+
+#endif
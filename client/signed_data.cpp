@@ -1,10 +1,11 @@
 #include "signed_data.h"
 #include "websocket_endpoint.h"
+#include "DataMessage.h"
 
 
 void SignedData::sendSignedMessage(std::string data, EVP_PKEY * private_key, websocket_endpoint* endpoint, int id, int counter) {
     if (!endpoint) {
-        std::cerr << "Error: endpoint is null." << std::endl;
+        LOG_WARN("Error: endpoint is null.");
         return;
     }
 
@@ -16,7 +17,7 @@ void SignedData::sendSignedMessage(std::string data, EVP_PKEY * private_key, web
     // Generate signature and check if it is valid
     std::string signature = ClientSignature::generateSignature(data, private_key, std::to_string(counter));
     if (signature.empty()) {
-        std::cerr << "Error: Signature generation failed." << std::endl;
+        LOG_WARN("Error: Signature generation failed.");
         return;
     }
     message["signature"] = signature;
@@ -26,13 +27,13 @@ void SignedData::sendSignedMessage(std::string data, EVP_PKEY * private_key, web
     // Get metadata for the connection
     connection_metadata::ptr metadata = endpoint->get_metadata(id);
     if (!metadata) {
-        std::cerr << "Error: Metadata not found for id " << id << std::endl;
+        LOG_WARN("Error: Metadata not found for id " << id);
         return;
     }
 
     // Check if the connection is open
     if (metadata->get_status() != "Open") {
-        std::cerr << "Connection is not open." << std::endl;
+        LOG_WARN("Connection is not open.");
         return;
     }
 
@@ -42,9 +43,9 @@ void SignedData::sendSignedMessage(std::string data, EVP_PKEY * private_key, web
 
     // Check for errors in sending
     if (ec) {
-        std::cerr << "> Error sending signed_data message: " << ec.message() << std::endl;
+        LOG_WARN("> Error sending signed_data message: " << ec.message());
     } else {
-        std::cout << "> signed_data message sent" << std::endl;
+        LOG_INFO("> signed_data message sent");
     }
 }
 
@@ -59,12 +60,12 @@ std::string SignedData::decryptSignedMessage(std::string message, EVP_PKEY * pri
         
     }catch (nlohmann::json::parse_error& e) {
         // Catch parse error exception and display error message
-        std::cerr << "Invalid JSON format: " << e.what() << std::endl;
+        LOG_WARN("Invalid JSON format: " << e.what());
     }
     
     if(message_json.contains("type")){
         if (message_json["type"] != "signed_data") {
-            std::cerr << "Not signed data!" << std::endl;
+            LOG_WARN("Not signed data!");
             return "";
         }
     }
@@ -86,27 +87,48 @@ std::string SignedData::decryptSignedMessage(std::string message, EVP_PKEY * pri
                 // You can continue with decryption or other operations here
                 // decryptData(data);  // Assuming you have a function to decrypt the data
             } catch (const nlohmann::json::parse_error& e) {
-                std::cerr << "Failed to parse JSON from string: " << e.what() << std::endl;
+                LOG_WARN("Failed to parse JSON from string: " << e.what());
                 return "";
             }
         } else {
-            std::cerr << "'data' is not a string." << std::endl;
+            LOG_WARN("'data' is not a string.");
             return "";
         }
     } else {
-        std::cerr << "'data' key does not exist in message_json." << std::endl;
+        LOG_WARN("'data' key does not exist in message_json.");
         return "";
     }
+    return decryptSignedMessage(data, private_key);
+}
+
+std::string SignedData::decryptSignedMessage(const nlohmann::json& data, EVP_PKEY * private_key) {
     std::vector<std::string> aesKeys;
     std::string decrypted_key;
 
     // Iterate over the encrypted symmetric keys
 
     if (data.contains("symm_keys") && data["symm_keys"].is_array()) {
+        const nlohmann::json& symm_keys = data["symm_keys"];
+
+        // Key IDs name the key each symmetric key was encrypted with, only the ones matching this key are decrypted.
+        // Messages without them (or with a mismatched list) fall back to trying every symmetric key.
+        const nlohmann::json* key_ids = nullptr;
+        std::string own_key_id;
+        if (data.contains("symm_key_ids") && data["symm_key_ids"].is_array() && data["symm_key_ids"].size() == symm_keys.size()) {
+            key_ids = &data["symm_key_ids"];
+            own_key_id = DataMessage::keyId(private_key);
+            if (own_key_id.empty()) {
+                key_ids = nullptr;
+            }
+        }
 
-        for (const auto& element : data["symm_keys"]) {
+        for (size_t i = 0; i < symm_keys.size(); i++) {
+            const nlohmann::json& element = symm_keys[i];
+            if (key_ids && (!(*key_ids)[i].is_string() || (*key_ids)[i].get_ref<const std::string&>() != own_key_id)) {
+                continue;
+            }
             if  (!element.is_string()){
-                std::cerr << "Element is not an object!" << std::endl;
+                LOG_WARN("Element is not an object!");
             } else {
                 std::string key_dump = Base64::decode(element);
 
@@ -120,7 +142,7 @@ std::string SignedData::decryptSignedMessage(std::string message, EVP_PKEY * pri
 
                     // Create vectors to hold the key, ciphertext, iv, and tag
                     std::vector<unsigned char> key = hexToBytes(decrypted_key); // Convert decrypted key to vector
-                    std::string iv_str = Base64::decode(data["iv"].get<std::string>());
+                    std::string iv_str = Base64::decode(data.at("iv").get<std::string>());
 
                     std::vector<unsigned char> iv = hexToBytes(iv_str);
 
@@ -139,7 +161,7 @@ std::string SignedData::decryptSignedMessage(std::string message, EVP_PKEY * pri
                         std::vector<unsigned char> ciphertext = hexToBytes(chat_str);
 
                         if (ciphertext.size() < 16){
-                            std::cerr << "Ciphertext is too small to contain tag" << std::endl;
+                            LOG_WARN("Ciphertext is too small to contain tag");
                             return "";
                         }
                         // Split the ciphertext: last 16 bytes are the tag, the rest is the actual ciphertext
@@ -148,7 +170,7 @@ std::string SignedData::decryptSignedMessage(std::string message, EVP_PKEY * pri
                         // Decrypt the message
                         std::vector<unsigned char> decrypted_text;
                         if (!AESGCM::aes_gcm_decrypt(actual_ciphertext, key, iv, tag, decrypted_text)) {
-                            std::cerr << "\nDecryption failed!: AES" << std::endl;
+                            LOG_WARN("\nDecryption failed!: AES");
                             return "";
                         }
 
@@ -156,19 +178,19 @@ std::string SignedData::decryptSignedMessage(std::string message, EVP_PKEY * pri
                         std::string decrypted_message(decrypted_text.begin(), decrypted_text.end());
                         return decrypted_message;
                     } else {
-                        std::cerr << "Chat is null, cannot decrypt" << std::endl;
+                        LOG_WARN("Chat is null, cannot decrypt");
                         return "";
                     }
                 } else {
-                    std::cerr << "\nDecryption failed!: RSA" << std::endl;
+                    LOG_WARN("\nDecryption failed!: RSA");
                 }
             }
 
         }
     }  else {
-        std::cerr << "symm_keys is not an array!" <<std::endl;
+        LOG_WARN("symm_keys is not an array!");
     }
-    std::cerr << "Message was not meant for you" << std::endl;
+    LOG_DEBUG("Message was not meant for you");
     return "";
 }
 
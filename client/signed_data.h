@@ -8,6 +8,7 @@
 #include "client_key_gen.h"
 #include "base64.h"
 #include "hexToBytes.h"
+#include "logger.h"
 
 class websocket_endpoint;
 
@@ -21,10 +22,16 @@ class SignedData{
         void static sendSignedMessage(std::string data, EVP_PKEY * private_key, websocket_endpoint* endpoint, int id, int counter);
         /* 
             Iterates over a signed message and attempts to decrypt the aes key with it's own private key
+            If the message has "symm_key_ids", only the aes keys with this key's ID are decrypted.
             Returns the decrypted message.
             Function to decrypt a signed messsage's content, does not verify the reciever or check counter
             Ensure the entire message is provided.
          */
         std::string static decryptSignedMessage(std::string data, EVP_PKEY * private_key);
+        /*
+            Same as above, but takes the already parsed data field of a signed message.
+            Used by the message handler so the message does not need to be serialised and parsed again.
+        */
+        std::string static decryptSignedMessage(const nlohmann::json& data, EVP_PKEY * private_key);
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "signed_envelope.h"
+
+// Parses the outer JSON and the data string it carries, each exactly once
+bool SignedEnvelope::parse(const std::string& payload){
+    try {
+        // Attempt to parse the string as JSON
+        message = nlohmann::json::parse(payload);
+
+    }catch (nlohmann::json::parse_error& e) {
+        // Catch parse error exception and display error message
+        std::cerr << "Invalid JSON format: " << e.what() << std::endl;
+        return false;
+    }
+
+    if(!message.is_object() || !message.contains("data")){
+        return true;
+    }
+
+    if(!message["data"].is_string()){
+        std::cerr << "'data' is not a string." << std::endl;
+        return true;
+    }
+
+    try {
+        // Attempt to parse the data string as JSON
+        data = nlohmann::json::parse(rawData());
+
+    }catch (nlohmann::json::parse_error& e) {
+        // Catch parse error exception and display error message
+        std::cerr << "Invalid JSON format: " << e.what() << std::endl;
+        data = nlohmann::json();
+    }
+    return true;
+}
+
+bool SignedEnvelope::isSigned() const{
+    if(!message.is_object()){
+        return false;
+    }
+    auto signature = message.find("signature");
+    auto counter = message.find("counter");
+    return signature != message.end() && signature->is_string() && counter != message.end() && counter->is_number_integer();
+}
+
+// Returns a reference to the string stored in the parsed message to avoid copying the data field
+const std::string& SignedEnvelope::rawData() const{
+    static const std::string empty;
+    if(!message.is_object()){
+        return empty;
+    }
+    auto found = message.find("data");
+    if(found == message.end() || !found->is_string()){
+        return empty;
+    }
+    return found->get_ref<const std::string&>();
+}
+
+std::string SignedEnvelope::signedBytes() const{
+    return rawData() + std::to_string(counter());
+}
+
+std::string SignedEnvelope::signature() const{
+    return message["signature"].get<std::string>();
+}
+
+int SignedEnvelope::counter() const{
+    return message["counter"].get<int>();
+}
@@ -0,0 +1,46 @@
+#ifndef SIGNED_ENVELOPE_H
+#define SIGNED_ENVELOPE_H
+#include <string>
+#include <iostream>
+#include <nlohmann/json.hpp> // For JSON library
+
+/*
+    Parsed view of a received message, shared by the client and server message handlers.
+
+    The outer JSON is parsed once, and if a "data" field is present the string it holds is parsed once into data.
+    The raw "data" bytes are kept exactly as the sender signed them, so signatures are checked against the
+    received bytes rather than a re-serialised copy of the parsed JSON.
+
+    {
+        "type": "signed_data",
+        "data": "<JSON string>",
+        "counter": 12345,
+        "signature": "<Base64 signature of data + counter>"
+    }
+*/
+class SignedEnvelope{
+    public:
+        nlohmann::json message; // Outer message
+        nlohmann::json data; // Parsed data field, empty if the message has no data field
+
+        /*
+            Parses a raw payload into message and data.
+            Returns false if the payload is not valid JSON, data is left empty if the data field is invalid.
+        */
+        bool parse(const std::string& payload);
+
+        // Returns true if the message carries a signature and counter
+        bool isSigned() const;
+
+        // Returns the data field exactly as it was received, or an empty string if there is none
+        const std::string& rawData() const;
+
+        // Returns the bytes covered by the signature (raw data + counter)
+        std::string signedBytes() const;
+
+        // Returns the signature and counter of the message, only valid if isSigned() is true
+        std::string signature() const;
+        int counter() const;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#include "utc_time.h"
+
+#include <chrono>
+
+std::atomic<long long> UtcTime::cachedNow(0);
+
+namespace {
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar
+long long daysFromCivil(long long year, unsigned month, unsigned day){
+    year -= month <= 2;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    unsigned yearOfEra = (unsigned)(year - era * 400);
+    unsigned dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (long long)dayOfEra - 719468;
+}
+
+// Date of a number of days since 1970-01-01
+void civilFromDays(long long days, long long& year, unsigned& month, unsigned& day){
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned dayOfEra = (unsigned)(days - era * 146097);
+    unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    unsigned monthIndex = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    year = (long long)yearOfEra + era * 400 + (month <= 2);
+}
+
+unsigned daysInMonth(long long year, unsigned month){
+    static const unsigned days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leap ? 29 : days[month - 1];
+}
+
+// Reads count digits, returns false if any of them isn't a digit
+bool digits(const char* text, int count, unsigned& value){
+    value = 0;
+    for(int i = 0; i < count; i++){
+        if(text[i] < '0' || text[i] > '9'){
+            return false;
+        }
+        value = value * 10 + (unsigned)(text[i] - '0');
+    }
+    return true;
+}
+
+void writeDigits(char* out, int count, unsigned value){
+    for(int i = count - 1; i >= 0; i--){
+        out[i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+}
+
+std::time_t UtcTime::systemNow(){
+    return std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+}
+
+std::time_t UtcTime::now(){
+    long long cached = cachedNow.load(std::memory_order_relaxed);
+    return cached != 0 ? (std::time_t)cached : systemNow();
+}
+
+bool UtcTime::parse(const std::string& text, std::time_t& time){
+    return parse(text.data(), text.size(), time);
+}
+
+bool UtcTime::parse(const char* text, size_t length, std::time_t& time){
+    // YYYY-MM-DDTHH:MM:SSZ
+    if(length != timestampLength || text[4] != '-' || text[7] != '-' || text[10] != 'T' || text[13] != ':' || text[16] != ':' || text[19] != 'Z'){
+        return false;
+    }
+
+    unsigned year, month, day, hour, minute, second;
+    if(!digits(text, 4, year) || !digits(text + 5, 2, month) || !digits(text + 8, 2, day) ||
+       !digits(text + 11, 2, hour) || !digits(text + 14, 2, minute) || !digits(text + 17, 2, second)){
+        return false;
+    }
+    if(month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) || hour > 23 || minute > 59 || second > 60){
+        return false;
+    }
+
+    // A leap second (:60) is read as the first second of the next minute, as std::mktime does
+    time = (std::time_t)(daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second);
+    return true;
+}
+
+std::string UtcTime::format(std::time_t time){
+    char timestamp[timestampLength];
+    format(time, timestamp);
+    return std::string(timestamp, timestampLength);
+}
+
+void UtcTime::format(std::time_t time, char* out){
+    long long seconds = (long long)time;
+    long long days = seconds / 86400;
+    long long secondOfDay = seconds % 86400;
+    if(secondOfDay < 0){
+        secondOfDay += 86400;
+        days--;
+    }
+
+    long long year;
+    unsigned month, day;
+    civilFromDays(days, year, month, day);
+
+    writeDigits(out, 4, (unsigned)year);
+    out[4] = '-';
+    writeDigits(out + 5, 2, month);
+    out[7] = '-';
+    writeDigits(out + 8, 2, day);
+    out[10] = 'T';
+    writeDigits(out + 11, 2, (unsigned)(secondOfDay / 3600));
+    out[13] = ':';
+    writeDigits(out + 14, 2, (unsigned)(secondOfDay / 60 % 60));
+    out[16] = ':';
+    writeDigits(out + 17, 2, (unsigned)(secondOfDay % 60));
+    out[19] = 'Z';
+}
+
+UtcClock::UtcClock(int interval_ms){
+    interval = interval_ms > 0 ? interval_ms : 1;
+    UtcTime::cachedNow.store((long long)UtcTime::systemNow(), std::memory_order_relaxed);
+    ticker = std::thread(&UtcClock::run, this);
+}
+
+UtcClock::~UtcClock(){
+    {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        stopping = true;
+    }
+    stopped.notify_one();
+    ticker.join();
+    UtcTime::cachedNow.store(0, std::memory_order_relaxed);
+}
+
+void UtcClock::run(){
+    std::unique_lock<std::mutex> lock(clockMutex);
+    while(!stopped.wait_for(lock, std::chrono::milliseconds(interval), [this]{ return stopping; })){
+        UtcTime::cachedNow.store((long long)UtcTime::systemNow(), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef UTC_TIME_H
+#define UTC_TIME_H
+#include <string>
+#include <ctime>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/*
+    UTC timestamps in the "%Y-%m-%dT%H:%M:%SZ" form chats use for their time-to-die, shared by the client and server.
+
+    Timestamps are parsed and formatted by hand rather than with std::get_time/std::put_time, so neither builds a
+    stream, allocates (other than the returned string) or calls the non thread safe std::gmtime. Times are seconds
+    since the Unix epoch in UTC, whatever the machine's time zone.
+
+    now() reads the time a running UtcClock last stored, so finding the time for every message is a single load.
+*/
+class UtcTime{
+    public:
+        // Length of a timestamp, e.g. "2024-10-17T09:30:00Z"
+        static const size_t timestampLength = 20;
+
+        // Seconds since the epoch, as last stored by a UtcClock, or read from the system clock if none is running
+        static std::time_t now();
+
+        /*
+            Parses a timestamp, returns false (leaving time unchanged) if it isn't exactly in the
+            "%Y-%m-%dT%H:%M:%SZ" form or names a date that doesn't exist.
+        */
+        static bool parse(const std::string& text, std::time_t& time);
+        static bool parse(const char* text, size_t length, std::time_t& time);
+
+        // Formats a time as a timestamp
+        static std::string format(std::time_t time);
+
+        // Writes the timestamp's timestampLength characters to out, without a null terminator
+        static void format(std::time_t time, char* out);
+
+    private:
+        friend class UtcClock;
+
+        // Time last stored by a UtcClock, 0 if no clock is running
+        static std::atomic<long long> cachedNow;
+
+        static std::time_t systemNow();
+};
+
+/*
+    Keeps the time returned by UtcTime::now() up to date, storing the system time every interval on its own thread.
+    The cached time is at most one interval behind, which is fine for time-to-die checks made to the second.
+    Stopped when destroyed, UtcTime::now() then reads the system clock again.
+*/
+class UtcClock{
+    private:
+        std::thread ticker;
+        std::mutex clockMutex;
+        std::condition_variable stopped;
+        bool stopping = false;
+        int interval;
+
+        void run();
+    public:
+        explicit UtcClock(int interval_ms = 100);
+        ~UtcClock();
+};
+
+#endif
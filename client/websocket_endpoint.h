@@ -11,6 +11,8 @@
 #include "aes_encrypt.h"
 #include "client.h"
 #include "websocket_metadata.h"
+#include "utc_time.h"
+#include "logger.h"
 
 class SignedData;
 
@@ -57,7 +59,7 @@ public:
         client::connection_ptr con = m_endpoint.get_connection(uri, ec);
 
         if (ec) {
-            std::cout << "> Connect initialization error: " << ec.message() << std::endl;
+            LOG_WARN("> Connect initialization error: " << ec.message());
             return -1;
         }
 
@@ -113,7 +115,7 @@ public:
         
         con_list::iterator metadata_it = m_connection_list.find(id);
         if (metadata_it == m_connection_list.end()) {
-            std::cout << "> No connection found with id " << id << std::endl;
+            LOG_WARN("> No connection found with id " << id);
             return;
         }else if (metadata_it->second->get_status() != "Open") {
             // Only close open connections
@@ -122,7 +124,7 @@ public:
         
         m_endpoint.close(metadata_it->second->get_hdl(), code, reason, ec);
         if (ec) {
-            std::cout << "> Error initiating close: " << ec.message() << std::endl;
+            LOG_WARN("> Error initiating close: " << ec.message());
         }else{
             // Remove connection from list
             m_connection_list.erase(id);
@@ -147,5 +149,6 @@ private:
     int m_next_id;
     std::string m_fingerprint;
     EVP_PKEY* m_privateKey;
+    UtcClock m_clock; // Time used to stamp and check time-to-die
 };
 #endif
\ No newline at end of file
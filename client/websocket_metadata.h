@@ -17,6 +17,12 @@
 #include "client_signature.h"
 #include "client_key_gen.h"
 #include "signed_data.h"
+#include "signed_envelope.h"
+#include "key_cache.h"
+#include "replay_window.h"
+#include "utc_time.h"
+#include "logger.h"
+#include "MessageGenerator.h"
 // using to generate current time
 #include <chrono>
 #include <ctime>
@@ -65,51 +71,19 @@ public:
         std::cout << s.str() << std::endl;
     }
 
-    std::time_t current_time(){
-        // Generate current time
-        std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
-        std::time_t convTime = std::chrono::system_clock::to_time_t(now);
-
-        // Convert to GMT time and time structure
-        std::tm* utc_tm = std::gmtime(&convTime);
-
-        auto timepoint = std::mktime(utc_tm);
-
-        return timepoint;
-    }
-
-    // Map to store latest counter for each user
-    std::unordered_map <std::string, int> latestCounters;
+    // Counters seen from each sender, stored against the sender's fingerprint
+    ReplayWindow replayWindow;
 
     void on_message(client* c, websocketpp::connection_hdl hdl, client::message_ptr msg, std::string fingerprint, EVP_PKEY* privateKey) {
         // Vulnerable code: the payload without validation
         std::string payload = msg->get_payload();
 
-        // Deserialize JSON message
-        nlohmann::json messageJSON;
-        try {
-            // Attempt to parse the string as JSON
-            messageJSON = nlohmann::json::parse(payload);
-            
-        }catch (nlohmann::json::parse_error& e) {
-            // Catch parse error exception and display error message
-            std::cerr << "Invalid JSON format: " << e.what() << std::endl;
-        }
-        //nlohmann::json messageJSON = nlohmann::json::parse(payload);
-        std::string dataString;
-        nlohmann::json data;
-
-        if(messageJSON.contains("data")){
-            dataString = messageJSON["data"].get<std::string>();
-            try {
-                // Attempt to parse the string as JSON
-                data = nlohmann::json::parse(dataString);
-                
-            }catch (nlohmann::json::parse_error& e) {
-                // Catch parse error exception and display error message
-                std::cerr << "JSON format: " << e.what() << std::endl;
-            }
-        }
+        // Deserialize JSON message and its signed data field, each is only parsed once
+        SignedEnvelope envelope;
+        envelope.parse(payload);
+
+        nlohmann::json& messageJSON = envelope.message;
+        nlohmann::json& data = envelope.data;
         
         if(messageJSON.contains("type")){
             if(messageJSON["type"] == "client_list"){
@@ -118,6 +92,20 @@ public:
                 global_client_list->update(messageJSON);
                 std::cout << "\n";
 
+                std::pair<int, std::pair<int, std::string>> myInfo = global_client_list->retrieveClientFromFingerprint(fingerprint);
+                if(myInfo.first != -1){
+                    global_client_list->printUsers(myInfo.first, myInfo.second.first);
+                }
+            }else if(messageJSON["type"] == "client_list_delta"){
+                // A delta was missed, ask for the full list again
+                if(!global_client_list->applyDelta(messageJSON)){
+                    websocketpp::lib::error_code ec;
+                    c->send(hdl, MessageGenerator::clientListRequestMessage(), websocketpp::frame::opcode::text, ec);
+                    return;
+                }
+                std::cout << "\nClient list updated" << std::endl;
+                std::cout << "\n";
+
                 std::pair<int, std::pair<int, std::string>> myInfo = global_client_list->retrieveClientFromFingerprint(fingerprint);
                 if(myInfo.first != -1){
                     global_client_list->printUsers(myInfo.first, myInfo.second.first);
@@ -126,44 +114,43 @@ public:
                 if(data.contains("sender") && messageJSON.contains("signature") && messageJSON.contains("counter") && data.contains("message")){
 
                 }else{
-                    std::cerr << "Invalid JSON provided" << std::endl;
+                    LOG_WARN("Invalid JSON provided");
                     return;
                 }
-                std::pair<int, std::pair<int, std::string>> chatInfo = global_client_list->retrieveClientFromFingerprint(data["sender"]);
+                // Parsed once, the client list and replay window are keyed on the digest rather than the text
+                FingerprintDigest sender = FingerprintDigest::fromText(data["sender"].get<std::string>());
+                std::pair<int, std::pair<int, std::string>> chatInfo = global_client_list->retrieveClientFromFingerprint(sender);
 
                 if(chatInfo.first == -1){
-                    std::cout << "Invalid fingerprint received in public message" << std::endl;
+                    LOG_WARN("Invalid fingerprint received in public message");
                     return;
                 }
 
                 int server_id = chatInfo.first;
                 int client_id = chatInfo.second.first;
                 std::string public_key = chatInfo.second.second;
-                EVP_PKEY* pubKey = Client_Key_Gen::stringToPEM(public_key);
+                KeyCache::Handle pubKey = KeyCache::get(public_key);
 
                 std::string signature = messageJSON["signature"];
                 int counter = messageJSON["counter"];
 
-                if(!ClientSignature::verifySignature(signature, data.dump() + std::to_string(counter), pubKey)){
-                    std::cout << "Invalid signature" << std::endl;
+                if(!pubKey || !ClientSignature::verifySignature(signature, envelope.signedBytes(), pubKey.get())){
+                    LOG_WARN("Invalid signature");
                     return;
                 }
-                std::cout << "Verified signature" << std::endl;
+                LOG_DEBUG("Verified signature");
 
                 // counter check
-                if (counter <= latestCounters[signature]) {
-                    std::cout << "Replay attack detected! Message discarded." << std::endl;
+                if (!replayWindow.check(sender, counter)) {
+                    LOG_WARN("Replay attack detected! Message discarded.");
                     return;
-                }        
-
-                //update latest counter
-                latestCounters[signature] = counter;
+                }
 
                 std::cout << "Public chat received from client " << client_id << " on server " << server_id << std::endl;
                 
                 std::cout << data["message"] << std::endl;
             }else if(data["type"] == "chat"){
-                std::string decrypted_str = SignedData::decryptSignedMessage(messageJSON.dump(), privateKey);
+                std::string decrypted_str = SignedData::decryptSignedMessage(data, privateKey);
                 if(decrypted_str == ""){
                     return;
                 }
@@ -174,27 +161,19 @@ public:
                     if(chat.contains("participants") && messageJSON.contains("signature") && messageJSON.contains("counter") && chat.contains("message") && data.contains("time-to-die")){
 
                     }else{
-                        std::cerr << "Invalid JSON provided" << std::endl;
+                        LOG_WARN("Invalid JSON provided");
                         return;
                     }
                     
-                    std::string ttd_timestamp_str = data["time-to-die"];
-
                     //parse the TTD timestamp
-                    std::tm ttd_tm = {};
-                    std::istringstream ss(ttd_timestamp_str);
-                    ss >> std::get_time(&ttd_tm, "%Y-%m-%dT%H:%M:%SZ");
-
-                    if (ss.fail()) {
-                        std::cout << "Invalid TTD Format";
+                    std::time_t ttd_timepoint;
+                    if (!data["time-to-die"].is_string() || !UtcTime::parse(data["time-to-die"].get_ref<const std::string&>(), ttd_timepoint)) {
+                        LOG_WARN("Invalid TTD Format, discarding packet.");
+                        return;
                     }
 
-                    std::time_t ttd_timepoint = std::mktime(&ttd_tm);
-
-                    std::time_t now = current_time();
-
-                    if (now >= ttd_timepoint) {
-                        std::cout << "Message expired based on TTD, discarding packet." << std::endl;
+                    if (UtcTime::now() >= ttd_timepoint) {
+                        LOG_WARN("Message expired based on TTD, discarding packet.");
                         return;
                     }
 
@@ -203,34 +182,32 @@ public:
                     std::vector<std::string> participants = chat["participants"].get<std::vector<std::string>>();
 
                     // If parsing is successful, you can work with the JSON object
-                    std::pair<int, std::pair<int, std::string>> chatInfo = global_client_list->retrieveClientFromFingerprint(participants[0]);
+                    FingerprintDigest sender = FingerprintDigest::fromText(participants[0]);
+                    std::pair<int, std::pair<int, std::string>> chatInfo = global_client_list->retrieveClientFromFingerprint(sender);
                     if(chatInfo.first == -1){
-                        std::cout<<"Invalid fingerprint received in message"<<std::endl;
+                        LOG_WARN("Invalid fingerprint received in message");
                         return;
                     }
 
                     int server_id = chatInfo.first;
                     int client_id = chatInfo.second.first;
                     std::string public_key = chatInfo.second.second;
-                    EVP_PKEY* pubKey = Client_Key_Gen::stringToPEM(public_key);
+                    KeyCache::Handle pubKey = KeyCache::get(public_key);
 
                     std::string signature = messageJSON["signature"];
                     int counter = messageJSON["counter"];
 
-                    if(!ClientSignature::verifySignature(signature, data.dump() + std::to_string(counter), pubKey)){
-                        std::cout << "Invalid signature" << std::endl;
+                    if(!pubKey || !ClientSignature::verifySignature(signature, envelope.signedBytes(), pubKey.get())){
+                        LOG_WARN("Invalid signature");
                         return;
                     }
-                    std::cout << "Verified signature" << std::endl;
+                    LOG_DEBUG("Verified signature");
 
                     // counter check
-                    if (counter <= latestCounters[signature]) {
-                        std::cout << "Replay attack detected! Message discarded." << std::endl;
+                    if (!replayWindow.check(sender, counter)) {
+                        LOG_WARN("Replay attack detected! Message discarded.");
                         return;
-                    }        
-
-                    //update latest counter
-                    latestCounters[signature] = counter;
+                    }
 
                     std::cout << "Chat received from client " << client_id << " on server " << server_id << std::endl << std::endl;
                     std::cout << chat["message"] << "\n" << std::endl;
@@ -238,7 +215,7 @@ public:
                     for(int i=1; i<(int)participants.size(); i++){
                         std::pair<int, std::pair<int, std::string>> chatInfo = global_client_list->retrieveClientFromFingerprint(participants[i]);
                         if(chatInfo.first == -1){
-                            std::cout<<"Invalid recipient fingerprint received in message"<<std::endl;
+                            LOG_WARN("Invalid recipient fingerprint received in message");
                             continue;
                         }
                         server_id = chatInfo.first;
@@ -247,15 +224,16 @@ public:
                     }
                 }catch (nlohmann::json::parse_error& e) {
                     // Catch parse error exception and display error message
-                    std::cerr << "Decrypted message is an Invalid JSON format: " << e.what() << std::endl;
+                    LOG_WARN("Decrypted message is an Invalid JSON format: " << e.what());
                 }
                 
             }else{
                 // Print the received message
-                std::cout << "> Invalid message type received: " << payload << std::endl;
+                LOG_WARN("> Invalid message type received");
+                LOG_PAYLOAD(payload);
             }
         }else{
-            std::cerr << "Invalid JSON provided" << std::endl;
+            LOG_WARN("Invalid JSON provided");
             return;
         }
         std::cout << "\n";
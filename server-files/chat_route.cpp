@@ -0,0 +1,467 @@
+#include "chat_route.h"
+
+#include <cctype>
+#include <climits>
+
+namespace {
+
+/*
+    Reads JSON text a character at a time.
+    A nested cursor reads JSON held in a string of the outer JSON, undoing the outer string's escapes as it goes and
+    stopping at the string's closing quote, so the inner JSON never needs to be copied out to be read.
+*/
+class JsonCursor{
+    private:
+        const char* position;
+        const char* end;
+        bool nested;
+        char current = 0; // 0 at the end of the text, or once the text can't be read
+        int width = 0; // Bytes of the text current was read from
+
+        void load(){
+            width = 0;
+            current = 0;
+            if(position >= end){
+                return;
+            }
+            if(!nested || (*position != '"' && *position != '\\')){
+                current = *position;
+                width = 1;
+                return;
+            }
+            if(*position == '"' || position + 1 >= end){
+                return;
+            }
+            current = unescape(position[1]);
+            width = current ? 2 : 0;
+        }
+
+    public:
+        JsonCursor(const char* begin, const char* last, bool inString) : position(begin), end(last), nested(inString) {
+            load();
+        }
+
+        char peek() const { return current; }
+        const char* at() const { return position; }
+
+        void next(){
+            position += width;
+            load();
+        }
+
+        // Moves past characters that need no unescaping or checking, straight over the text rather than a character at a time
+        void skipPlain(){
+            while(position < end && *position != '"' && *position != '\\' && plain(*position)){
+                position++;
+            }
+            load();
+        }
+
+        void skipSpace(){
+            while(current == ' ' || current == '\n' || current == '\r' || current == '\t'){
+                next();
+            }
+        }
+
+        bool expect(char c){
+            skipSpace();
+            if(current != c){
+                return false;
+            }
+            next();
+            return true;
+        }
+
+        /*
+            Reads a string, only keeping it if out is given. Returns false for \u escapes and characters outside printable
+            ASCII, they are left to the full parser (which rejects control characters and checks UTF-8).
+        */
+        bool readString(std::string* out){
+            if(!expect('"')){
+                return false;
+            }
+            while(current != '"'){
+                if(current == 0 || !plain(current)){
+                    return false;
+                }
+                char c = current;
+                if(c == '\\'){
+                    next();
+                    c = unescape(current);
+                    if(c == 0){
+                        return false;
+                    }
+                }
+                if(!out){
+                    next();
+                    skipPlain();
+                    continue;
+                }
+                out->push_back(c);
+                next();
+            }
+            next();
+            return true;
+        }
+
+        bool readStrings(std::vector<std::string>& out){
+            if(!expect('[')){
+                return false;
+            }
+            skipSpace();
+            if(current == ']'){
+                next();
+                return true;
+            }
+            while(true){
+                out.emplace_back();
+                if(!readString(&out.back())){
+                    return false;
+                }
+                skipSpace();
+                if(current == ']'){
+                    next();
+                    return true;
+                }
+                if(current != ','){
+                    return false;
+                }
+                next();
+            }
+        }
+
+        bool readInt(int& out){
+            skipSpace();
+            bool negative = current == '-';
+            if(negative){
+                next();
+            }
+            if(current < '0' || current > '9'){
+                return false;
+            }
+            // No leading zeros, as in JSON
+            if(current == '0'){
+                next();
+                if(current >= '0' && current <= '9'){
+                    return false;
+                }
+                out = 0;
+                return true;
+            }
+            long long value = 0;
+            while(current >= '0' && current <= '9'){
+                value = value * 10 + (current - '0');
+                if(value > INT_MAX){
+                    return false;
+                }
+                next();
+            }
+            out = (int)(negative ? -value : value);
+            return true;
+        }
+
+        /*
+            Skips over a value without keeping any of it, checking it is valid JSON. Objects and arrays are followed with
+            a stack of the containers open rather than recursion, so deeply nested values can't overflow the stack.
+        */
+        bool skipValue(){
+            std::vector<char> open; // Closing bracket of each container being skipped, innermost last
+            while(true){
+                skipSpace();
+                if(current == '{' || current == '['){
+                    char close = current == '{' ? '}' : ']';
+                    next();
+                    skipSpace();
+                    if(current == close){
+                        next();
+                    }else{
+                        open.push_back(close);
+                        if(close == '}' && (!readString(nullptr) || !expect(':'))){
+                            return false;
+                        }
+                        continue;
+                    }
+                }else if(current == '"'){
+                    if(!readString(nullptr)){
+                        return false;
+                    }
+                }else if(!skipLiteral("true") && !skipLiteral("false") && !skipLiteral("null") && !skipNumber()){
+                    return false;
+                }
+
+                // Close the containers the value ends, or move on to the next member or element
+                while(true){
+                    if(open.empty()){
+                        return true;
+                    }
+                    skipSpace();
+                    if(current == ','){
+                        next();
+                        if(open.back() == '}' && (!readString(nullptr) || !expect(':'))){
+                            return false;
+                        }
+                        break;
+                    }
+                    if(current != open.back()){
+                        return false;
+                    }
+                    next();
+                    open.pop_back();
+                }
+            }
+        }
+
+        // Skips true, false or null. Returns false if the text isn't the literal, having only moved past a matching start of it
+        bool skipLiteral(const char* literal){
+            if(current != literal[0]){
+                return false;
+            }
+            for(const char* c = literal; *c; c++){
+                if(current != *c){
+                    return false;
+                }
+                next();
+            }
+            return !isalnum((unsigned char)current);
+        }
+
+        // Skips a number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        bool skipNumber(){
+            if(current == '-'){
+                next();
+            }
+            if(current == '0'){
+                next();
+            }else if(current >= '1' && current <= '9'){
+                skipDigits();
+            }else{
+                return false;
+            }
+            if(current == '.'){
+                next();
+                if(!skipDigits()){
+                    return false;
+                }
+            }
+            if(current == 'e' || current == 'E'){
+                next();
+                if(current == '+' || current == '-'){
+                    next();
+                }
+                if(!skipDigits()){
+                    return false;
+                }
+            }
+            return !isalnum((unsigned char)current) && current != '.';
+        }
+
+        // Skips at least one digit
+        bool skipDigits(){
+            if(current < '0' || current > '9'){
+                return false;
+            }
+            while(current >= '0' && current <= '9'){
+                next();
+            }
+            return true;
+        }
+
+        // Printable ASCII, the only characters read in strings here
+        static bool plain(char c){
+            return c >= 0x20 && c < 0x7f;
+        }
+
+        // Character an escape stands for, 0 if it isn't one read here
+        static char unescape(char c){
+            switch(c){
+                case '"': return '"';
+                case '\\': return '\\';
+                case '/': return '/';
+                case 'b': return '\b';
+                case 'f': return '\f';
+                case 'n': return '\n';
+                case 'r': return '\r';
+                case 't': return '\t';
+                default: return 0;
+            }
+        }
+};
+
+// Calls field(key) for each member of an object, which reads the member's value
+template<typename Field>
+bool readObject(JsonCursor& cursor, Field field){
+    if(!cursor.expect('{')){
+        return false;
+    }
+    cursor.skipSpace();
+    if(cursor.peek() == '}'){
+        cursor.next();
+        return true;
+    }
+    std::string key;
+    while(true){
+        key.clear();
+        if(!cursor.readString(&key) || !cursor.expect(':') || !field(key)){
+            return false;
+        }
+        cursor.skipSpace();
+        if(cursor.peek() == '}'){
+            cursor.next();
+            return true;
+        }
+        if(cursor.peek() != ','){
+            return false;
+        }
+        cursor.next();
+    }
+}
+
+// Recipients are only kept if every fingerprint is valid, otherwise the chat is sent to every client
+void readRecipients(const std::vector<std::string>& fingerprints, std::vector<FingerprintDigest>& recipients){
+    recipients.clear();
+    recipients.reserve(fingerprints.size());
+    for(const auto& fingerprint: fingerprints){
+        FingerprintDigest digest = FingerprintDigest::fromText(fingerprint);
+        if(!digest.valid()){
+            recipients.clear();
+            return;
+        }
+        recipients.push_back(digest);
+    }
+}
+
+}
+
+bool ChatRoute::scan(const std::string& payload){
+    const char* begin = payload.data();
+    const char* end = begin + payload.size();
+    JsonCursor cursor(begin, end, false);
+
+    bool hasType = false, hasData = false, hasCounter = false, hasSignature = false, isChat = false, hasTTD = false, hasDestinations = false;
+    std::vector<std::string> fingerprints;
+
+    bool read = readObject(cursor, [&](const std::string& key){
+        if(key == "data"){
+            cursor.skipSpace();
+            if(cursor.peek() != '"'){
+                return false;
+            }
+            dataBegin = cursor.at() + 1 - begin;
+
+            // Only the last data field counts if it is repeated
+            isChat = hasTTD = hasDestinations = false;
+            time_to_die.clear();
+            destination_servers.clear();
+            fingerprints.clear();
+
+            // Read the data string's JSON where it is
+            JsonCursor data(cursor.at() + 1, end, true);
+            bool readData = readObject(data, [&](const std::string& field){
+                if(field == "type"){
+                    std::string type;
+                    isChat = data.readString(&type) && type == "chat";
+                    return isChat;
+                }
+                // A repeated field replaces the earlier one, as it does when the message is parsed in full
+                if(field == "time-to-die"){
+                    time_to_die.clear();
+                    return hasTTD = data.readString(&time_to_die);
+                }
+                if(field == "destination_servers"){
+                    destination_servers.clear();
+                    return hasDestinations = data.readStrings(destination_servers);
+                }
+                if(field == "recipients"){
+                    fingerprints.clear();
+                    return data.readStrings(fingerprints);
+                }
+                return data.skipValue();
+            });
+            data.skipSpace();
+            if(!readData || data.peek() != 0 || data.at() >= end || *data.at() != '"'){
+                return false;
+            }
+            dataEnd = data.at() - begin;
+
+            // Carry on after the data string's closing quote
+            cursor = JsonCursor(data.at() + 1, end, false);
+            return hasData = true;
+        }
+        if(key == "counter"){
+            return hasCounter = cursor.readInt(counter);
+        }
+        if(key == "signature"){
+            signature.clear();
+            return hasSignature = cursor.readString(&signature);
+        }
+        if(key == "type"){
+            std::string type;
+            return hasType = cursor.readString(&type) && type == "signed_data";
+        }
+        return cursor.skipValue();
+    });
+
+    // Nothing but whitespace may follow the message, as when it is parsed in full
+    cursor.skipSpace();
+    if(!read || cursor.peek() != 0 || cursor.at() != end){
+        return false;
+    }
+    if(!hasType || !hasData || !hasCounter || !hasSignature || !isChat || !hasTTD || !hasDestinations){
+        return false;
+    }
+    readRecipients(fingerprints, recipients);
+    scanned = true;
+    return true;
+}
+
+bool ChatRoute::read(const SignedEnvelope& envelope){
+    const nlohmann::json& fields = envelope.data;
+    if(!envelope.isSigned() || !fields.is_object()){
+        return false;
+    }
+
+    auto ttd = fields.find("time-to-die");
+    auto destinations = fields.find("destination_servers");
+    if(ttd == fields.end() || !ttd->is_string() || destinations == fields.end() || !destinations->is_array()){
+        return false;
+    }
+    for(const auto& destination: *destinations){
+        if(!destination.is_string()){
+            return false;
+        }
+        destination_servers.push_back(destination.get<std::string>());
+    }
+    time_to_die = ttd->get<std::string>();
+    signature = envelope.signature();
+    counter = envelope.counter();
+
+    std::vector<std::string> fingerprints;
+    auto named = fields.find("recipients");
+    if(named != fields.end() && named->is_array()){
+        for(const auto& fingerprint: *named){
+            fingerprints.push_back(fingerprint.is_string() ? fingerprint.get<std::string>() : "");
+        }
+    }
+    readRecipients(fingerprints, recipients);
+
+    data = envelope.rawData();
+    scanned = false;
+    return true;
+}
+
+std::string ChatRoute::signedBytes(const std::string& payload) const{
+    if(!scanned){
+        return data + std::to_string(counter);
+    }
+
+    // Undo the data string's escapes, giving the data exactly as the sender signed it
+    std::string bytes;
+    bytes.reserve(dataEnd - dataBegin + 12);
+    const char* begin = payload.data();
+    JsonCursor cursor(begin + dataBegin, begin + dataEnd, true);
+    while(cursor.peek() != 0){
+        bytes.push_back(cursor.peek());
+        cursor.next();
+    }
+    return bytes + std::to_string(counter);
+}
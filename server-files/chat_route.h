@@ -0,0 +1,51 @@
+#ifndef chat_route_h
+#define chat_route_h
+
+#include <string>
+#include <vector>
+
+#include "../client/signed_envelope.h"
+#include "../client/fingerprint_digest.h"
+
+/*
+    The fields of a private chat the server routes it with, read without parsing the chat itself.
+
+    scan() reads them straight from the received payload: the outer message's signature and counter, and the type,
+    time-to-die, destination_servers and recipients held in its data string. The data string is read where it is,
+    undoing its escapes as it goes, and every other field (the chat, iv, symm_keys...) is skipped over without being
+    copied, so no JSON is built for the ciphertext. The chat is forwarded as the payload it was received in.
+
+    Payloads scan() can't read (e.g. \u escapes in the data string) are parsed in full, read() takes the same fields
+    from the parsed message.
+*/
+class ChatRoute{
+    public:
+        std::string signature;
+        int counter = 0;
+        std::string time_to_die;
+        std::vector<std::string> destination_servers;
+        std::vector<FingerprintDigest> recipients; // Empty if the chat doesn't name its recipients (or names an invalid one)
+
+        /*
+            Reads the routing fields of a chat from a raw payload.
+            Returns false if the payload isn't a signed chat or can't be read this way, it should then be parsed in full.
+        */
+        bool scan(const std::string& payload);
+
+        /*
+            Reads the routing fields of a chat from a parsed message.
+            Returns false if a field the chat needs is missing.
+        */
+        bool read(const SignedEnvelope& envelope);
+
+        // Returns the bytes covered by the signature (data field as it was signed + counter)
+        std::string signedBytes(const std::string& payload) const;
+
+    private:
+        bool scanned = false;
+        size_t dataBegin = 0; // Position of the data string's contents in the scanned payload
+        size_t dataEnd = 0;
+        std::string data; // Data field of a parsed message
+};
+
+#endif
@@ -0,0 +1,20 @@
+#include "connection_slots.h"
+
+int ConnectionSlots::acquire(){
+    if(!freeSlots.empty()){
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+    return nextSlot++;
+}
+
+void ConnectionSlots::release(int slot){
+    if(slot >= 0 && slot < nextSlot){
+        freeSlots.push_back(slot);
+    }
+}
+
+int ConnectionSlots::capacity() const {
+    return nextSlot;
+}
@@ -0,0 +1,152 @@
+#ifndef connection_slots_h
+#define connection_slots_h
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstddef>
+#include <type_traits>
+
+/*
+    Base class of every WebSocket++ connection the server makes or accepts (the connection_base of deflate_config and
+    slot_client_config), so the connection carries its slot with it.
+    A slot is given out when the connection opens and is -1 until then.
+*/
+struct connection_slot{
+    int slot = -1;
+};
+
+/*
+    Hands out small integer slots to connections, reusing the slots of closed connections so slots stay dense.
+    Not locked, each shard has its own and the outbound connections' slots are only used with the outbound map's mutex held.
+*/
+class ConnectionSlots{
+    private:
+        std::vector<int> freeSlots;
+        int nextSlot = 0;
+    public:
+        int acquire();
+        void release(int slot);
+
+        // One more than the highest slot given out
+        int capacity() const;
+};
+
+/*
+    Connections stored against their slot, so finding a connection is an array index rather than hashing its handle.
+
+    Supports the parts of std::unordered_map the connection tables use: find, count, operator[], erase (by slot or
+    iterator) and iteration over std::pair<int, Value> in slot order. Several tables can share one ConnectionSlots
+    (e.g. a connection moves from a shard's connection_map to its client_server_map keeping its slot), so a table is as
+    long as the highest slot stored in it and iteration skips the slots it doesn't hold.
+*/
+template<typename Value>
+class SlotTable{
+    public:
+        typedef std::pair<int, Value> value_type;
+
+    private:
+        std::vector<value_type> entries; // entries[slot], first is -1 if the slot is empty
+        size_t entryCount = 0;
+
+        template<bool Const>
+        class Iterator{
+            friend class SlotTable;
+            typedef typename std::conditional<Const, const SlotTable, SlotTable>::type table_type;
+            table_type* table;
+            size_t index;
+
+            void skipEmpty(){
+                while(index < table->entries.size() && table->entries[index].first < 0){
+                    index++;
+                }
+            }
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef typename SlotTable::value_type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef typename std::conditional<Const, const value_type*, value_type*>::type pointer;
+            typedef typename std::conditional<Const, const value_type&, value_type&>::type reference;
+
+            Iterator() : table(nullptr), index(0) {}
+            Iterator(table_type* t, size_t i) : table(t), index(i) { skipEmpty(); }
+            // Iterators convert to const iterators
+            template<bool OtherConst, typename = typename std::enable_if<Const && !OtherConst>::type>
+            Iterator(const Iterator<OtherConst>& other) : table(other.table), index(other.index) {}
+
+            reference operator*() const { return table->entries[index]; }
+            pointer operator->() const { return &table->entries[index]; }
+            Iterator& operator++(){ index++; skipEmpty(); return *this; }
+            Iterator operator++(int){ Iterator previous = *this; ++(*this); return previous; }
+            bool operator==(const Iterator& other) const { return index == other.index; }
+            bool operator!=(const Iterator& other) const { return index != other.index; }
+
+            template<bool> friend class Iterator;
+        };
+
+        bool holds(int slot) const {
+            return slot >= 0 && (size_t)slot < entries.size() && entries[slot].first >= 0;
+        }
+
+    public:
+        typedef Iterator<false> iterator;
+        typedef Iterator<true> const_iterator;
+
+        iterator begin(){ return iterator(this, 0); }
+        iterator end(){ return iterator(this, entries.size()); }
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, entries.size()); }
+
+        size_t size() const { return entryCount; }
+        bool empty() const { return entryCount == 0; }
+
+        void clear(){
+            entries.clear();
+            entryCount = 0;
+        }
+
+        iterator find(int slot){
+            return holds(slot) ? iterator(this, (size_t)slot) : end();
+        }
+        const_iterator find(int slot) const {
+            return holds(slot) ? const_iterator(this, (size_t)slot) : end();
+        }
+
+        size_t count(int slot) const {
+            return holds(slot) ? 1 : 0;
+        }
+
+        // The slot must have been given out by a ConnectionSlots (i.e. not negative)
+        Value& operator[](int slot){
+            if((size_t)slot >= entries.size()){
+                entries.resize((size_t)slot + 1, value_type(-1, Value()));
+            }
+            if(entries[slot].first < 0){
+                entries[slot].first = slot;
+                entryCount++;
+            }
+            return entries[slot].second;
+        }
+
+        size_t erase(int slot){
+            if(!holds(slot)){
+                return 0;
+            }
+            // Release whatever the entry held straight away
+            entries[slot] = value_type(-1, Value());
+            entryCount--;
+            return 1;
+        }
+
+        // Returns the iterator after the erased entry
+        iterator erase(const_iterator it){
+            size_t index = it.index;
+            erase((int)index);
+            return iterator(this, index + 1);
+        }
+        iterator erase(iterator it){
+            return erase(const_iterator(it));
+        }
+};
+
+#endif
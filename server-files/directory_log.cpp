@@ -0,0 +1,44 @@
+#include "directory_log.h"
+
+#include <map>
+#include <utility>
+
+DirectoryLog::DirectoryLog(size_t max_changes){
+    maxChanges = max_changes > 0 ? max_changes : 1;
+}
+
+long long DirectoryLog::record(int server_id, int client_id, KeyPool::Key public_key){
+    currentVersion++;
+    changes.push_back({currentVersion, server_id, client_id, public_key});
+
+    // Forget the oldest change, peers older than it now need the full directory
+    if(changes.size() > maxChanges){
+        oldestVersion = changes.front().version;
+        changes.pop_front();
+    }
+    return currentVersion;
+}
+
+long long DirectoryLog::version() const{
+    return currentVersion;
+}
+
+bool DirectoryLog::since(long long since, std::vector<Change>& result) const{
+    if(since < oldestVersion || since > currentVersion){
+        return false;
+    }
+
+    // Only the last change to each client matters
+    std::map<std::pair<int, int>, const Change*> latest;
+    for(const auto& change: changes){
+        if(change.version > since){
+            latest[std::make_pair(change.server_id, change.client_id)] = &change;
+        }
+    }
+
+    result.clear();
+    for(const auto& change: latest){
+        result.push_back(*change.second);
+    }
+    return true;
+}
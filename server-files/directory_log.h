@@ -0,0 +1,51 @@
+#ifndef directory_log_h
+#define directory_log_h
+
+#include <string>
+#include <deque>
+#include <vector>
+
+#include "../client/key_pool.h"
+
+/*
+    Recent changes to a client directory (the client list or this server's client update), used to send peers only
+    the clients that joined or left since the version they already have.
+
+    Every change increases the version by one. Only the last max_changes changes are kept, a peer that is further
+    behind than that has to be sent the full directory instead.
+
+    Not locked, ServerList only uses it under its own lock.
+*/
+class DirectoryLog{
+    public:
+        struct Change{
+            long long version;
+            int server_id;
+            int client_id;
+            KeyPool::Key public_key; // Null if the client left
+        };
+
+        // size_t max_changes - Number of changes kept
+        DirectoryLog(size_t max_changes = 1024);
+
+        // Records a client joining (public_key set) or leaving (public_key null), returns the new version
+        long long record(int server_id, int client_id, KeyPool::Key public_key);
+
+        // Current version of the directory
+        long long version() const;
+
+        /*
+            Fills changes with the net change to each client after version since (a client that joined and then left
+            is only listed as leaving), ordered by server ID then client ID.
+            Returns false if since is older than the changes kept, or newer than the current version.
+        */
+        bool since(long long since, std::vector<Change>& changes) const;
+
+    private:
+        size_t maxChanges;
+        long long currentVersion = 0;
+        long long oldestVersion = 0; // Changes after this version are all in changes
+        std::deque<Change> changes;
+};
+
+#endif
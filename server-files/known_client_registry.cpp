@@ -0,0 +1,113 @@
+#include "known_client_registry.h"
+
+#include <algorithm>
+
+KnownClientRegistry::KnownClientRegistry(size_t capacity){
+    maxClients = capacity > 0 ? capacity : 1;
+}
+
+void KnownClientRegistry::load(std::unordered_map<int, mapping_entry>& mapping){
+    clients.clear();
+    clientIDs.clear();
+    recency.clear();
+
+    // Oldest first, clients never seen since last seen was recorded keep their ID order
+    std::vector<std::pair<long long, int>> order;
+    order.reserve(mapping.size());
+    for(const auto& client: mapping){
+        order.emplace_back(client.second.last_seen, client.first);
+    }
+    std::sort(order.begin(), order.end());
+
+    clients.reserve(mapping.size());
+    clientIDs.reserve(mapping.size());
+    for(const auto& client: order){
+        insert(client.second, mapping[client.second]);
+    }
+    mapping.clear();
+}
+
+int KnownClientRegistry::find(const std::string& digest, const KeyPool::Key& public_key) const{
+    auto known = clientIDs.find(digest);
+    if(known == clientIDs.end()){
+        return -1;
+    }
+    auto client = clients.find(known->second);
+    if(client == clients.end() || client->second.entry.public_key != public_key){
+        return -1;
+    }
+    return known->second;
+}
+
+const mapping_entry* KnownClientRegistry::get(int client_id) const{
+    auto client = clients.find(client_id);
+    if(client == clients.end()){
+        return nullptr;
+    }
+    return &client->second.entry;
+}
+
+const mapping_entry& KnownClientRegistry::insert(int client_id, const mapping_entry& entry){
+    auto client = clients.find(client_id);
+    if(client != clients.end()){
+        clientIDs.erase(client->second.entry.digest);
+        recency.erase(client->second.position);
+        clients.erase(client);
+    }
+
+    known_client& known = clients[client_id];
+    known.entry = entry;
+    known.position = recency.insert(recency.end(), client_id);
+    clientIDs[entry.digest] = client_id;
+    return known.entry;
+}
+
+void KnownClientRegistry::seen(int client_id, long long last_seen){
+    auto client = clients.find(client_id);
+    if(client == clients.end()){
+        return;
+    }
+    client->second.entry.last_seen = last_seen;
+    recency.splice(recency.end(), recency, client->second.position);
+}
+
+void KnownClientRegistry::evict(const std::function<bool(int)>& is_connected, std::vector<int>& evicted_ids){
+    auto position = recency.begin();
+    while(clients.size() > maxClients && position != recency.end()){
+        int client_id = *position;
+        if(is_connected(client_id)){
+            // Still connected, leave them and try the next oldest
+            skipped++;
+            ++position;
+            continue;
+        }
+
+        auto client = clients.find(client_id);
+        clientIDs.erase(client->second.entry.digest);
+        clients.erase(client);
+        position = recency.erase(position);
+
+        evicted_ids.push_back(client_id);
+        evicted++;
+    }
+}
+
+void KnownClientRegistry::setCapacity(size_t capacity){
+    maxClients = capacity > 0 ? capacity : 1;
+}
+
+size_t KnownClientRegistry::capacity() const{
+    return maxClients;
+}
+
+size_t KnownClientRegistry::size() const{
+    return clients.size();
+}
+
+size_t KnownClientRegistry::evictedCount() const{
+    return evicted;
+}
+
+size_t KnownClientRegistry::skippedCount() const{
+    return skipped;
+}
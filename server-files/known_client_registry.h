@@ -0,0 +1,67 @@
+#ifndef known_client_registry_h
+#define known_client_registry_h
+
+#include <string>
+#include <unordered_map>
+#include <list>
+#include <vector>
+#include <functional>
+
+#include "mapping_snapshot.h"
+#include "../client/flat_map.h"
+
+/*
+    Clients that belong to this server, bounded to a capacity so the mapping can't grow forever.
+
+    Clients are kept in the order they were last seen. Once there are more known clients than the capacity, the
+    clients not seen for longest are evicted, skipping any the caller says are still connected. Evicted clients get
+    a new ID if they return. Not locked, ServerList only uses it while holding its own lock.
+*/
+class KnownClientRegistry{
+    public:
+        KnownClientRegistry(size_t capacity = 100000);
+
+        // Replaces the registry with a loaded mapping, ordered by last seen
+        void load(std::unordered_map<int, mapping_entry>& mapping);
+
+        // Returns the ID of the client with this key, or -1 if it isn't known. Keys are interned so only pointers are compared.
+        int find(const std::string& digest, const KeyPool::Key& public_key) const;
+
+        // Returns nullptr if the client isn't known
+        const mapping_entry* get(int client_id) const;
+
+        // Adds a client as the most recently seen
+        const mapping_entry& insert(int client_id, const mapping_entry& entry);
+
+        // Marks a known client as seen now
+        void seen(int client_id, long long last_seen);
+
+        /*
+            Evicts the least recently seen clients until the registry is within capacity. Clients is_connected returns
+            true for are skipped. The IDs of evicted clients are added to evicted_ids.
+        */
+        void evict(const std::function<bool(int)>& is_connected, std::vector<int>& evicted_ids);
+
+        void setCapacity(size_t capacity);
+        size_t capacity() const;
+        size_t size() const;
+
+        size_t evictedCount() const; // Clients evicted since the server started
+        size_t skippedCount() const; // Times a connected client was passed over for eviction
+
+    private:
+        struct known_client{
+            mapping_entry entry;
+            std::list<int>::iterator position; // Position in recency
+        };
+
+        FlatMap<int, known_client> clients;
+        FlatMap<std::string, int> clientIDs; // Client IDs stored against the SHA-256 digest of their public key
+        std::list<int> recency; // Client IDs, least recently seen first
+
+        size_t maxClients;
+        size_t evicted = 0;
+        size_t skipped = 0;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#include "link_index.h"
+
+void LinkIndex::add(int server_id, const std::string& address, int slot){
+    slotsByID[server_id] = slot;
+    slotsByAddress[LinkIndex::address(address)] = slot;
+}
+
+void LinkIndex::remove(int server_id, const std::string& address, int slot){
+    auto byID = slotsByID.find(server_id);
+    if(byID != slotsByID.end() && byID->second == slot){
+        slotsByID.erase(byID);
+    }
+
+    auto byAddress = slotsByAddress.find(LinkIndex::address(address));
+    if(byAddress != slotsByAddress.end() && byAddress->second == slot){
+        slotsByAddress.erase(byAddress);
+    }
+}
+
+int LinkIndex::find(int server_id) const {
+    auto link = slotsByID.find(server_id);
+    return link == slotsByID.end() ? -1 : link->second;
+}
+
+int LinkIndex::find(const std::string& address) const {
+    auto link = slotsByAddress.find(address);
+    return link == slotsByAddress.end() ? -1 : link->second;
+}
+
+size_t LinkIndex::size() const {
+    return slotsByID.size();
+}
+
+std::string LinkIndex::address(const std::string& uri){
+    size_t scheme = uri.find("://");
+    return scheme == std::string::npos ? uri : uri.substr(scheme + 3);
+}
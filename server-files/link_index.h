@@ -0,0 +1,37 @@
+#ifndef link_index_h
+#define link_index_h
+
+#include <string>
+
+#include "../client/flat_map.h"
+
+/*
+    Finds the connection to a neighbouring server by its server ID or its address, so routing a message to a server
+    doesn't walk every connection.
+
+    Links are stored as the connection's slot in its connection_table (see connection_slots.h). Addresses are stored
+    without the "ws://" of the server's URI, the form they take in destination_servers.
+    Not locked, the outbound links are only used with the outbound map's mutex held.
+*/
+class LinkIndex{
+    private:
+        FlatMap<int, int> slotsByID;
+        FlatMap<std::string, int> slotsByAddress;
+    public:
+        // Called when a connection to a server opens, replaces any link already recorded for the server
+        void add(int server_id, const std::string& address, int slot);
+
+        // Called when a connection closes, links replaced by a newer connection to the server are left in place
+        void remove(int server_id, const std::string& address, int slot);
+
+        // Slot of the connection to a server, -1 if there isn't one
+        int find(int server_id) const;
+        int find(const std::string& address) const;
+
+        size_t size() const;
+
+        // Address of a server URI without its scheme, e.g. "ws://127.0.0.1:9002" -> "127.0.0.1:9002"
+        static std::string address(const std::string& uri);
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "mapping_journal.h"
+
+#include <cstdio>
+#include <iostream>
+
+MappingJournal::MappingJournal(const std::string& snapshot_file, const std::string& json_file, const std::string& journal_file, size_t compact_every){
+    snapshotFile = snapshot_file;
+    jsonFile = json_file;
+    journalFile = journal_file;
+    compactEvery = compact_every > 0 ? compact_every : 1;
+
+    writer = std::thread(&MappingJournal::run, this);
+}
+
+MappingJournal::~MappingJournal(){
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        stopping = true;
+    }
+    journalReady.notify_one();
+    writer.join();
+}
+
+bool MappingJournal::load(std::unordered_map<int, mapping_entry>& loaded, int& highest_id){
+    std::lock_guard<std::mutex> lock(journalMutex);
+    bool found = false;
+
+    // Snapshot, or the JSON mapping file if there isn't one yet
+    if(MappingSnapshot::load(snapshotFile, loaded, highestID)){
+        found = true;
+    }else if(MappingSnapshot::importJson(jsonFile, loaded, highestID)){
+        found = true;
+        compactPending = true;
+    }
+
+    // Replay clients journalled since the snapshot was written
+    std::ifstream journalIn(journalFile);
+    if(journalIn){
+        found = true;
+        std::string line;
+        while(std::getline(journalIn, line)){
+            if(line.empty()){
+                continue;
+            }
+            nlohmann::json record = nlohmann::json::parse(line, nullptr, false);
+            if(record.is_discarded() || !record.contains("client-id")){
+                // Last record was cut off part way through being written
+                continue;
+            }
+            int client_id = record["client-id"];
+            journalled++;
+
+            if(record.contains("removed")){
+                loaded.erase(client_id);
+                continue;
+            }
+            if(record.contains("public-key")){
+                mapping_entry entry;
+                if(record.contains("digest") && record.contains("fingerprint")){
+                    entry.public_key = KeyPool::intern(record["public-key"].get<std::string>());
+                    entry.digest = record["digest"];
+                    entry.fingerprint = record["fingerprint"];
+                }else{
+                    entry = MappingSnapshot::makeEntry(record["public-key"]);
+                }
+                loaded[client_id] = std::move(entry);
+                if(client_id > highestID){
+                    highestID = client_id;
+                }
+            }
+            if(record.contains("last-seen")){
+                auto client = loaded.find(client_id);
+                if(client != loaded.end()){
+                    client->second.last_seen = record["last-seen"];
+                }
+            }
+        }
+    }
+
+    mapping = loaded;
+    highest_id = highestID;
+
+    // Fold the replayed journal (or imported JSON mapping) into the snapshot straight away
+    if(journalled > 0){
+        compactPending = true;
+    }
+    if(compactPending){
+        journalReady.notify_one();
+    }
+    return found;
+}
+
+void MappingJournal::append(int client_id, const mapping_entry& entry){
+    queue({Added, client_id, entry, entry.last_seen});
+}
+
+void MappingJournal::seen(int client_id, long long last_seen){
+    queue({Seen, client_id, mapping_entry(), last_seen});
+}
+
+void MappingJournal::remove(int client_id){
+    queue({Removed, client_id, mapping_entry(), 0});
+}
+
+void MappingJournal::queue(journal_record record){
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        pending.push_back(std::move(record));
+    }
+    journalReady.notify_one();
+}
+
+void MappingJournal::setJsonExport(bool enabled){
+    {
+        std::lock_guard<std::mutex> lock(journalMutex);
+        jsonExport = enabled;
+        compactPending = compactPending || enabled;
+    }
+    journalReady.notify_one();
+}
+
+void MappingJournal::run(){
+    std::unique_lock<std::mutex> lock(journalMutex);
+    while(true){
+        journalReady.wait(lock, [this]{ return stopping || compactPending || !pending.empty(); });
+
+        if(pending.empty() && !compactPending && stopping){
+            break;
+        }
+
+        std::deque<journal_record> records;
+        records.swap(pending);
+        bool compactNow = compactPending;
+        bool writeJson = jsonExport;
+        compactPending = false;
+
+        // Write without holding the lock so new clients can still be queued
+        lock.unlock();
+        write(records);
+        if(compactNow || journalled >= compactEvery){
+            compact(writeJson);
+        }
+        lock.lock();
+    }
+    bool writeJson = jsonExport;
+    lock.unlock();
+
+    // Leave a single up to date snapshot behind
+    if(journalled > 0){
+        compact(writeJson);
+    }
+}
+
+void MappingJournal::write(const std::deque<journal_record>& records){
+    if(records.empty()){
+        return;
+    }
+    if(!journal.is_open()){
+        journal.open(journalFile, std::ios::app);
+    }
+
+    for(const auto& record: records){
+        nlohmann::json line;
+        line["client-id"] = record.client_id;
+        if(record.type == Added){
+            line["public-key"] = *record.entry.public_key;
+            line["digest"] = record.entry.digest;
+            line["fingerprint"] = record.entry.fingerprint;
+            line["last-seen"] = record.entry.last_seen;
+            mapping[record.client_id] = record.entry;
+            if(record.client_id > highestID){
+                highestID = record.client_id;
+            }
+        }else if(record.type == Seen){
+            line["last-seen"] = record.last_seen;
+            auto client = mapping.find(record.client_id);
+            if(client != mapping.end()){
+                client->second.last_seen = record.last_seen;
+            }
+        }else{
+            line["removed"] = true;
+            mapping.erase(record.client_id);
+        }
+        journal << line.dump() << "\n";
+        journalled++;
+    }
+    journal.flush();
+}
+
+void MappingJournal::compact(bool writeJson){
+    // Write the snapshot to a temporary file first so a crash never leaves a partly written snapshot
+    std::string tempFile = snapshotFile + ".tmp";
+    if(!MappingSnapshot::save(tempFile, mapping, highestID)){
+        std::cerr << "Unable to write mapping snapshot" << std::endl;
+        return;
+    }
+    if(std::rename(tempFile.c_str(), snapshotFile.c_str()) != 0){
+        std::cerr << "Unable to replace mapping snapshot" << std::endl;
+        return;
+    }
+
+    if(writeJson){
+        tempFile = jsonFile + ".tmp";
+        if(!MappingSnapshot::exportJson(tempFile, mapping) || std::rename(tempFile.c_str(), jsonFile.c_str()) != 0){
+            std::cerr << "Unable to write mapping file" << std::endl;
+        }
+    }
+
+    // Every journalled client is now in the snapshot
+    journal.close();
+    journal.open(journalFile, std::ios::trunc);
+    journalled = 0;
+}
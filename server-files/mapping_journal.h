@@ -0,0 +1,94 @@
+#ifndef mapping_journal_h
+#define mapping_journal_h
+
+#include <string>
+#include <unordered_map>
+#include <deque>
+#include <utility>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <nlohmann/json.hpp> // For JSON library
+
+#include "mapping_snapshot.h"
+
+/*
+    Persists the server's known client mapping without writing the whole mapping for every new client.
+
+    New clients are appended to a journal (one JSON object per line) by a background writer thread, so registering a
+    client never touches the disk on the server threads. Returning clients and evicted clients are journalled the same
+    way, as {"client-id", "last-seen"} and {"client-id", "removed"} records. Once compact_every records have been
+    journalled the writer rewrites the binary snapshot (see MappingSnapshot) and empties the journal.
+
+    Loading reads the snapshot then replays the journal on top of it, a partly written last line is ignored. If there
+    is no snapshot yet the JSON mapping file is imported instead, and with setJsonExport() the JSON mapping file is
+    rewritten alongside the snapshot so it stays usable by other tools.
+*/
+class MappingJournal{
+    public:
+        /*
+            std::string snapshot_file - Binary snapshot the full mapping is compacted into
+            std::string json_file - JSON mapping file, imported if there is no snapshot
+            std::string journal_file - File new clients are appended to
+            size_t compact_every - Number of journalled clients before the snapshot is rewritten
+        */
+        MappingJournal(const std::string& snapshot_file, const std::string& json_file, const std::string& journal_file, size_t compact_every = 1024);
+
+        // Writes any clients still queued and compacts the journal
+        ~MappingJournal();
+
+        /*
+            Loads the snapshot (or JSON mapping file) and replays the journal into mapping, returns false if none exist.
+            highest_id is set to the highest client ID ever journalled, including evicted clients. Call before append().
+        */
+        bool load(std::unordered_map<int, mapping_entry>& mapping, int& highest_id);
+
+        // Queues a new client to be journalled
+        void append(int client_id, const mapping_entry& entry);
+
+        // Queues a returning client's new last seen time
+        void seen(int client_id, long long last_seen);
+
+        // Queues the removal of an evicted client
+        void remove(int client_id);
+
+        // Also write the JSON mapping file whenever the snapshot is written, starting now
+        void setJsonExport(bool enabled);
+
+    private:
+        std::string snapshotFile;
+        std::string jsonFile;
+        std::string journalFile;
+        size_t compactEvery;
+
+        enum RecordType { Added, Seen, Removed };
+        struct journal_record{
+            RecordType type;
+            int client_id;
+            mapping_entry entry; // Only set for Added
+            long long last_seen; // Only set for Seen
+        };
+
+        // Only used by the writer thread once loaded
+        std::unordered_map<int, mapping_entry> mapping; // Full mapping, written out when compacting
+        int highestID = 0;
+        std::ofstream journal;
+        size_t journalled = 0; // Records in the journal since the last compaction
+
+        std::mutex journalMutex;
+        std::condition_variable journalReady;
+        std::deque<journal_record> pending; // Records waiting to be journalled
+        bool compactPending = false;
+        bool jsonExport = false;
+        bool stopping = false;
+
+        std::thread writer;
+
+        void run();
+        void queue(journal_record record);
+        void write(const std::deque<journal_record>& records);
+        void compact(bool writeJson);
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include "mapping_snapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp> // For JSON library
+
+#include "../client/Sha256Hash.h"
+#include "../client/key_cache.h"
+
+static const char snapshotMagic[] = "OLAFMAP2";
+static const size_t magicLength = sizeof(snapshotMagic) - 1;
+
+mapping_entry MappingSnapshot::makeEntry(const std::string& public_key){
+    mapping_entry entry;
+    entry.public_key = KeyPool::intern(public_key);
+    entry.digest = Sha256Hash::hashStringSha256(public_key);
+    entry.fingerprint = KeyCache::fingerprint(public_key);
+    return entry;
+}
+
+bool MappingSnapshot::load(const std::string& file, std::unordered_map<int, mapping_entry>& mapping, int& highest_id){
+    std::ifstream in(file, std::ios::binary);
+    if(!in){
+        return false;
+    }
+
+    // Read the whole file at once, records are then just copied out of it
+    in.seekg(0, std::ios::end);
+    std::streamoff size = in.tellg();
+    if(size < 0){
+        return false;
+    }
+    std::string buffer((size_t)size, '\0');
+    in.seekg(0, std::ios::beg);
+    in.read(&buffer[0], buffer.size());
+    const char* position = buffer.data();
+    const char* end = buffer.data() + buffer.size();
+
+    auto readInt = [&position, end](uint32_t& value){
+        if(end - position < (long)sizeof(value)){
+            return false;
+        }
+        std::memcpy(&value, position, sizeof(value));
+        position += sizeof(value);
+        return true;
+    };
+    auto readString = [&position, end](uint32_t length, std::string& value){
+        if((uint32_t)(end - position) < length){
+            return false;
+        }
+        value.assign(position, length);
+        position += length;
+        return true;
+    };
+
+    auto readLong = [&position, end](long long& value){
+        int64_t read;
+        if(end - position < (long)sizeof(read)){
+            return false;
+        }
+        std::memcpy(&read, position, sizeof(read));
+        position += sizeof(read);
+        value = read;
+        return true;
+    };
+
+    if(buffer.size() < magicLength || buffer.compare(0, magicLength, snapshotMagic) != 0){
+        std::cerr << "Invalid mapping snapshot" << std::endl;
+        return false;
+    }
+    position += magicLength;
+
+    uint32_t highest = 0;
+    uint32_t count;
+    if(!readInt(highest) || !readInt(count)){
+        std::cerr << "Invalid mapping snapshot" << std::endl;
+        return false;
+    }
+
+    // The count is only trusted as far as the file could hold that many records, a corrupt count fails below instead
+    const size_t minimumRecord = 4 * sizeof(uint32_t) + sizeof(int64_t);
+    std::unordered_map<int, mapping_entry> loaded;
+    loaded.reserve(std::min((size_t)count, (size_t)(end - position) / minimumRecord));
+    for(uint32_t i = 0; i < count; i++){
+        uint32_t client_id, digestLength, fingerprintLength, keyLength;
+        mapping_entry entry;
+        std::string public_key;
+        if(!readInt(client_id) || !readLong(entry.last_seen) || !readInt(digestLength) || !readInt(fingerprintLength) || !readInt(keyLength)
+            || !readString(digestLength, entry.digest) || !readString(fingerprintLength, entry.fingerprint) || !readString(keyLength, public_key)){
+            std::cerr << "Invalid mapping snapshot" << std::endl;
+            return false;
+        }
+        entry.public_key = KeyPool::intern(public_key);
+        if(client_id > highest){
+            highest = client_id;
+        }
+        loaded[(int)client_id] = std::move(entry);
+    }
+
+    mapping.swap(loaded);
+    highest_id = (int)highest;
+    return true;
+}
+
+bool MappingSnapshot::save(const std::string& file, const std::unordered_map<int, mapping_entry>& mapping, int highest_id){
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if(!out){
+        return false;
+    }
+
+    auto writeInt = [&out](uint32_t value){
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    out.write(snapshotMagic, magicLength);
+    writeInt((uint32_t)highest_id);
+    writeInt((uint32_t)mapping.size());
+    for(const auto& client: mapping){
+        int64_t last_seen = client.second.last_seen;
+        writeInt((uint32_t)client.first);
+        out.write(reinterpret_cast<const char*>(&last_seen), sizeof(last_seen));
+        writeInt((uint32_t)client.second.digest.size());
+        writeInt((uint32_t)client.second.fingerprint.size());
+        writeInt((uint32_t)client.second.public_key->size());
+        out << client.second.digest << client.second.fingerprint << *client.second.public_key;
+    }
+
+    out.flush();
+    return (bool)out;
+}
+
+bool MappingSnapshot::importJson(const std::string& file, std::unordered_map<int, mapping_entry>& mapping, int& highest_id){
+    std::ifstream in(file);
+    if(!in){
+        return false;
+    }
+
+    std::unordered_map<int, std::string> keys;
+    try {
+        nlohmann::json j_client_map;
+        in >> j_client_map;
+        keys = j_client_map.get<std::unordered_map<int, std::string>>();
+    }catch (nlohmann::json::exception& e) {
+        std::cerr << "Invalid mapping file: " << e.what() << std::endl;
+        return false;
+    }
+
+    mapping.clear();
+    mapping.reserve(keys.size());
+    highest_id = 0;
+    for(const auto& client: keys){
+        mapping[client.first] = makeEntry(client.second);
+        if(client.first > highest_id){
+            highest_id = client.first;
+        }
+    }
+    return true;
+}
+
+bool MappingSnapshot::exportJson(const std::string& file, const std::unordered_map<int, mapping_entry>& mapping){
+    std::unordered_map<int, std::string> keys;
+    for(const auto& client: mapping){
+        keys[client.first] = *client.second.public_key;
+    }
+
+    nlohmann::json j_map = keys;
+    std::ofstream out(file);
+    out << j_map.dump(4);
+    return (bool)out;
+}
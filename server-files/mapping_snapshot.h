@@ -0,0 +1,47 @@
+#ifndef mapping_snapshot_h
+#define mapping_snapshot_h
+
+#include <string>
+#include <unordered_map>
+
+#include "../client/key_pool.h"
+
+// A known client, with the digest and fingerprint of their key worked out once rather than on every load
+struct mapping_entry{
+    KeyPool::Key public_key; // Interned, so the journal's copy of the mapping and the server list share one string
+    std::string digest; // SHA-256 of the PEM string, used to find returning clients
+    std::string fingerprint; // Fingerprint of the key, see Fingerprint.h
+    long long last_seen = 0; // Seconds since the epoch the client last connected, used to evict clients not seen for longest
+};
+
+/*
+    Binary snapshot of the known client mapping, loaded with no JSON parsing and no hashing.
+
+    Layout, integers are 32 bit (last seen is 64 bit) in this machine's byte order:
+        "OLAFMAP2"
+        highest client ID ever given out (clients may have been evicted since)
+        record count
+        for each record:
+            client ID
+            last seen
+            digest length, fingerprint length, public key length
+            digest, fingerprint and public key bytes
+
+    The JSON mapping file (an array of [client ID, public key] pairs) can be imported and exported, importing works
+    out the digest and fingerprint of every key.
+*/
+class MappingSnapshot{
+    public:
+        // Builds an entry for a key, parsing it to find its fingerprint
+        static mapping_entry makeEntry(const std::string& public_key);
+
+        // Returns false if the file doesn't exist or isn't a valid snapshot, mapping is left unchanged if so
+        static bool load(const std::string& file, std::unordered_map<int, mapping_entry>& mapping, int& highest_id);
+        static bool save(const std::string& file, const std::unordered_map<int, mapping_entry>& mapping, int highest_id);
+
+        // Returns false if the file doesn't exist or isn't a valid mapping file
+        static bool importJson(const std::string& file, std::unordered_map<int, mapping_entry>& mapping, int& highest_id);
+        static bool exportJson(const std::string& file, const std::unordered_map<int, mapping_entry>& mapping);
+};
+
+#endif
@@ -0,0 +1,247 @@
+#include "outbound_links.h"
+
+#include <algorithm>
+
+OutboundLinks::OutboundLinks(ServerUtilities* utilities, EVP_PKEY* private_key, int counter, connection_table* outbound_server_server_map, std::mutex* outbound_map_mutex, int initial_delay_ms, int max_delay_ms){
+    this->utilities = utilities;
+    this->counter = counter;
+    privateKey = private_key;
+    outboundMap = outbound_server_server_map;
+    outboundMapMutex = outbound_map_mutex;
+    initialDelay = std::max(1, initial_delay_ms);
+    maxDelay = std::max(initialDelay, max_delay_ms);
+    jitter.seed(std::random_device()());
+
+    // Set logging settings for the client
+    endpoint.set_access_channels(websocketpp::log::alevel::none);
+    endpoint.set_error_channels(websocketpp::log::elevel::none);
+
+    // Initialize ASIO for the client, keep the event loop running while there are no links
+    endpoint.init_asio();
+    endpoint.start_perpetual();
+}
+
+OutboundLinks::~OutboundLinks(){
+    endpoint.stop_perpetual();
+    endpoint.stop();
+    if(loop.joinable()){
+        loop.join();
+    }
+}
+
+void OutboundLinks::start(){
+    loop = std::thread([this](){
+        endpoint.run();
+    });
+}
+
+void OutboundLinks::connect(int server_id, const std::string& uri){
+    endpoint.get_io_service().post([this, server_id, uri](){
+        {
+            std::lock_guard<std::mutex> lock(linksMutex);
+            auto link = links.find(server_id);
+            if(link == links.end()){
+                outbound_link added;
+                added.server_id = server_id;
+                added.uri = uri;
+                links.emplace(server_id, added);
+            }else if(link->second.state == LinkOpen || link->second.state == LinkConnecting){
+                LOG_INFO("Outbound connection already exists to server " << server_id);
+                return;
+            }else{
+                // The server is up, don't wait for the backoff
+                if(link->second.retry_timer){
+                    link->second.retry_timer->cancel();
+                }
+                link->second.failures = 0;
+            }
+        }
+        attempt(server_id);
+    });
+}
+
+void OutboundLinks::attempt(int server_id){
+    std::string uri;
+    unsigned generation;
+    {
+        std::lock_guard<std::mutex> lock(linksMutex);
+        auto link = links.find(server_id);
+        if(link == links.end()){
+            return;
+        }
+        link->second.state = LinkConnecting;
+        generation = ++link->second.generation;
+        uri = link->second.uri;
+    }
+
+    websocketpp::lib::error_code ec;
+    client::connection_ptr con = endpoint.get_connection(uri, ec);
+    if(ec){
+        failed(server_id, generation, ec.message());
+        return;
+    }
+
+    con->set_fail_handler([this, server_id, generation](websocketpp::connection_hdl hdl){
+        client::connection_ptr con = endpoint.get_con_from_hdl(hdl);
+        failed(server_id, generation, con->get_ec().message());
+    });
+    con->set_open_handler([this, server_id](websocketpp::connection_hdl hdl){
+        opened(server_id, hdl);
+    });
+    con->set_close_handler([this, server_id](websocketpp::connection_hdl hdl){
+        closed(server_id, hdl);
+    });
+
+    endpoint.connect(con);
+}
+
+void OutboundLinks::opened(int server_id, websocketpp::connection_hdl hdl){
+    std::string uri;
+    {
+        std::lock_guard<std::mutex> lock(linksMutex);
+        outbound_link& link = links[server_id];
+        link.state = LinkOpen;
+        link.connects++;
+        link.opened_at = std::chrono::steady_clock::now();
+        link.last_error.clear();
+        uri = link.uri;
+    }
+    LOG_INFO("\nSuccessfully connected to " << uri);
+
+    utilities->send_server_hello(&endpoint, hdl, privateKey, counter);
+
+    // Record the link in the outbound connection map, then ask for the server's clients
+    std::lock_guard<std::mutex> map_lock(*outboundMapMutex);
+    int slot = utilities->add_outbound(&endpoint, hdl, uri, server_id, *outboundMap);
+    utilities->send_client_update_request(&endpoint, slot, *outboundMap);
+}
+
+void OutboundLinks::failed(int server_id, unsigned generation, const std::string& error){
+    std::lock_guard<std::mutex> lock(linksMutex);
+    auto link = links.find(server_id);
+    if(link == links.end() || link->second.generation != generation){
+        return;
+    }
+    // The reason is kept for status() rather than printed, the test script treats "error" in the server's output as a failure
+    LOG_WARN("Connection to " << link->second.uri << " failed");
+    link->second.last_error = error;
+    link->second.failures++;
+    retry(link->second);
+}
+
+void OutboundLinks::closed(int server_id, websocketpp::connection_hdl hdl){
+    LOG_INFO("\nServer " << server_id << " closing outbound connection");
+
+    // Get connection pointer from the connection handle
+    client::connection_ptr con = endpoint.get_con_from_hdl(hdl);
+    {
+        std::lock_guard<std::mutex> map_lock(*outboundMapMutex);
+        utilities->remove_outbound(&endpoint, hdl, *outboundMap);
+    }
+
+    std::lock_guard<std::mutex> lock(linksMutex);
+    outbound_link& link = links[server_id];
+    std::string reason = con->get_remote_close_reason();
+    if(reason == "Server signature could not be verified."){
+        LOG_WARN("Invalid signature sent in hello");
+        link.state = LinkRejected;
+        link.last_error = reason;
+        return;
+    }
+    link.last_error = reason.empty() ? "Connection closed" : reason;
+
+    // Links that drop soon after opening keep backing off, a link that was stable starts again from the initial delay
+    long open_for = (long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - link.opened_at).count();
+    if(open_for >= maxDelay){
+        link.failures = 0;
+    }else{
+        link.failures++;
+    }
+    retry(link);
+}
+
+void OutboundLinks::retry(outbound_link& link){
+    // initial * 2^(failures - 1), doubled without overflowing past the maximum
+    long delay = initialDelay;
+    for(int i = 1; i < link.failures && delay < maxDelay; i++){
+        delay *= 2;
+    }
+    delay = std::min(delay, (long)maxDelay);
+
+    // Spread retries between half and all of the delay so servers that lost each other don't retry in step
+    delay = std::uniform_int_distribution<long>(delay / 2, delay)(jitter);
+
+    link.state = LinkWaiting;
+    link.retry_at = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay);
+    LOG_INFO("Trying to reconnect to server " << link.server_id << " in " << delay << "ms");
+
+    int server_id = link.server_id;
+    unsigned generation = link.generation;
+    link.retry_timer = endpoint.set_timer(delay, [this, server_id, generation](websocketpp::lib::error_code const &ec){
+        if(ec){
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(linksMutex);
+            auto waiting = links.find(server_id);
+            if(waiting == links.end() || waiting->second.generation != generation || waiting->second.state != LinkWaiting){
+                return;
+            }
+        }
+        attempt(server_id);
+    });
+}
+
+std::vector<outbound_link_status> OutboundLinks::status(){
+    std::lock_guard<std::mutex> lock(linksMutex);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    std::vector<outbound_link_status> links_status;
+    for(const auto& entry: links){
+        const outbound_link& link = entry.second;
+        outbound_link_status status;
+        status.server_id = link.server_id;
+        status.uri = link.uri;
+        status.state = link.state;
+        status.failures = link.failures;
+        status.connects = link.connects;
+        status.retry_in = 0;
+        if(link.state == LinkWaiting && link.retry_at > now){
+            status.retry_in = (long)std::chrono::duration_cast<std::chrono::milliseconds>(link.retry_at - now).count();
+        }
+        status.last_error = link.last_error;
+        links_status.push_back(status);
+    }
+    return links_status;
+}
+
+void OutboundLinks::reportStatus(int interval_ms){
+    interval_ms = std::max(1, interval_ms);
+    endpoint.get_io_service().post([this, interval_ms](){
+        logStatus(interval_ms);
+    });
+}
+
+void OutboundLinks::logStatus(int interval_ms){
+    endpoint.set_timer(interval_ms, [this, interval_ms](websocketpp::lib::error_code const &ec){
+        if(ec){
+            return;
+        }
+        for(const outbound_link_status& link: status()){
+            LOG_INFO("Server " << link.server_id << " (" << link.uri << "): " << stateName(link.state) << ", " << link.connects << " connects, "
+                     << link.failures << " failures" << (link.state == LinkWaiting ? ", retrying in " + std::to_string(link.retry_in) + "ms" : "")
+                     << (link.last_error.empty() ? "" : ", last failure: " + link.last_error));
+        }
+        logStatus(interval_ms);
+    });
+}
+
+const char* OutboundLinks::stateName(link_state state){
+    switch(state){
+        case LinkConnecting: return "connecting";
+        case LinkOpen: return "open";
+        case LinkWaiting: return "waiting";
+        case LinkRejected: return "rejected";
+    }
+    return "unknown";
+}
@@ -0,0 +1,118 @@
+#ifndef outbound_links_h
+#define outbound_links_h
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <random>
+#include <chrono>
+
+#include "server_utilities.h"
+
+// State of the outbound link to a neighbouring server
+enum link_state{
+    LinkConnecting, // A connection attempt is in progress
+    LinkOpen,
+    LinkWaiting, // Waiting for the backoff delay before the next attempt
+    LinkRejected // The server rejected our server_hello signature, not retried until it sends us a server_hello
+};
+
+// Snapshot of an outbound link, see OutboundLinks::status()
+struct outbound_link_status{
+    int server_id;
+    std::string uri;
+    link_state state;
+    int failures; // Failed attempts (or connections that closed soon after opening) since the link was last stable
+    int connects; // Times the link has opened
+    long retry_in; // Milliseconds until the next attempt if waiting, otherwise 0
+    std::string last_error;
+};
+
+/*
+    Owns every outbound (server-server) connection through one WebSocket++ client endpoint, run on a single thread.
+
+    connect() may be called from any thread. Attempts that fail, and links that close, are retried after an
+    exponential backoff with jitter (a random delay between half and all of initial * 2^failures, at most the maximum
+    delay), waited on with an asio timer so the event loop is never blocked. A link that stays open for longer than the
+    maximum delay starts its backoff again from the initial delay, so a neighbour that keeps dropping its connection
+    straight after accepting it is backed off too.
+
+    Open links are recorded in the outbound connection map with ServerUtilities::add_outbound(), so everything else
+    sends to them as before.
+*/
+class OutboundLinks{
+    private:
+        struct outbound_link{
+            int server_id;
+            std::string uri;
+            link_state state = LinkConnecting;
+            int failures = 0;
+            int connects = 0;
+            unsigned generation = 0; // Increased on every attempt, handlers for older attempts are ignored
+            client::timer_ptr retry_timer;
+            std::chrono::steady_clock::time_point retry_at;
+            std::chrono::steady_clock::time_point opened_at;
+            std::string last_error;
+        };
+
+        client endpoint;
+        std::thread loop;
+
+        ServerUtilities* utilities;
+        EVP_PKEY* privateKey;
+        int counter;
+        connection_table* outboundMap;
+        std::mutex* outboundMapMutex;
+
+        int initialDelay; // Milliseconds
+        int maxDelay;
+        std::mt19937 jitter; // Only used on the event loop
+
+        std::map<int, outbound_link> links; // By server ID
+        std::mutex linksMutex;
+
+        // Run on the event loop
+        void attempt(int server_id);
+        void opened(int server_id, websocketpp::connection_hdl hdl);
+        void failed(int server_id, unsigned generation, const std::string& error);
+        void closed(int server_id, websocketpp::connection_hdl hdl);
+
+        // Starts the backoff timer for a link, linksMutex must be held
+        void retry(outbound_link& link);
+
+        // Logs status() every interval, run on the event loop
+        void logStatus(int interval_ms);
+    public:
+        /*
+            ServerUtilities* utilities - Used to send server_hellos and client update requests, and record open links
+            EVP_PKEY* private_key - Private key of this server, signs the server_hellos
+            int counter - Counter sent in server_hellos
+            connection_table* outbound_server_server_map - Map of outbound connections, open links are added to it
+            std::mutex* outbound_map_mutex - Mutex guarding the map
+            int initial_delay_ms, max_delay_ms - Backoff delay after the first failure, and the most it grows to
+        */
+        OutboundLinks(ServerUtilities* utilities, EVP_PKEY* private_key, int counter, connection_table* outbound_server_server_map, std::mutex* outbound_map_mutex, int initial_delay_ms = 500, int max_delay_ms = 30000);
+        ~OutboundLinks();
+
+        // Starts the event loop thread
+        void start();
+
+        /*
+            Connects to a server if there isn't already a link to it.
+            A link waiting to retry, or rejected, is retried straight away (e.g. the server has just sent us a server_hello
+            so it is up).
+        */
+        void connect(int server_id, const std::string& uri);
+
+        // Returns the state of every link, for monitoring
+        std::vector<outbound_link_status> status();
+
+        // Logs the state of every link every interval_ms milliseconds, until the links are destroyed
+        void reportStatus(int interval_ms);
+
+        static const char* stateName(link_state state);
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "presence_scheduler.h"
+
+PresenceScheduler::PresenceScheduler(server* s, int window_ms, std::function<void(long long)> send_client_lists, std::function<void()> send_client_updates){
+    server_instance = s;
+    window = window_ms > 0 ? window_ms : 0;
+    sendClientLists = send_client_lists;
+    sendClientUpdates = send_client_updates;
+
+    // Allow the first change to be sent straight away
+    lastFlush = std::chrono::steady_clock::now() - std::chrono::milliseconds(window);
+}
+
+long long PresenceScheduler::markClientLists(){
+    std::lock_guard<std::mutex> lock(presenceMutex);
+    clientListsDirty = true;
+    version++;
+    schedule();
+    return version;
+}
+
+void PresenceScheduler::markClientUpdates(){
+    std::lock_guard<std::mutex> lock(presenceMutex);
+    clientUpdatesDirty = true;
+    schedule();
+}
+
+long long PresenceScheduler::currentVersion(){
+    std::lock_guard<std::mutex> lock(presenceMutex);
+    return version;
+}
+
+void PresenceScheduler::schedule(){
+    if(flushScheduled){
+        return;
+    }
+    flushScheduled = true;
+
+    // Flush once a full window has passed since the last flush, straight away if it already has
+    long elapsed = (long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lastFlush).count();
+    long wait = window - elapsed;
+    if(wait < 0){
+        wait = 0;
+    }
+
+    server_instance->set_timer(wait, [this](websocketpp::lib::error_code const &ec){
+        if(ec){
+            return;
+        }
+        flush();
+    });
+}
+
+void PresenceScheduler::flush(){
+    bool lists;
+    bool updates;
+    long long flushVersion;
+    {
+        std::lock_guard<std::mutex> lock(presenceMutex);
+        lists = clientListsDirty;
+        updates = clientUpdatesDirty;
+        flushVersion = version;
+
+        clientListsDirty = false;
+        clientUpdatesDirty = false;
+        flushScheduled = false;
+        lastFlush = std::chrono::steady_clock::now();
+    }
+
+    if(lists){
+        sendClientLists(flushVersion);
+    }
+    if(updates){
+        sendClientUpdates();
+    }
+}
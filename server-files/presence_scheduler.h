@@ -0,0 +1,59 @@
+#ifndef presence_scheduler_h
+#define presence_scheduler_h
+
+#include <functional>
+#include <mutex>
+#include <chrono>
+
+#include "server_utilities.h"
+
+/*
+    Coalesces client_list and client_update broadcasts.
+
+    Instead of broadcasting on every hello and every disconnect, changes mark the client lists and/or client updates
+    as dirty, and they are sent at most once per window. A burst of N hellos then sends one round of client lists
+    rather than N.
+
+    Every change to the client list increases its version. Connections remember the version they were last sent, so
+    a flush only needs to go to clients that are behind (e.g. a client that has just sent a hello and will request
+    the list itself is not sent another one).
+*/
+class PresenceScheduler{
+    private:
+        server* server_instance;
+        int window; // Minimum time between flushes in milliseconds
+
+        // Called to send client lists (with the version being sent) and client updates when a flush is due
+        std::function<void(long long)> sendClientLists;
+        std::function<void()> sendClientUpdates;
+
+        std::mutex presenceMutex;
+        bool clientListsDirty = false;
+        bool clientUpdatesDirty = false;
+        bool flushScheduled = false;
+        long long version = 0;
+        std::chrono::steady_clock::time_point lastFlush;
+
+        // Schedule a flush for the end of the current window, presenceMutex must be held
+        void schedule();
+        void flush();
+    public:
+        /*
+            server* s - Server instance, the flush timer runs on its io_service
+            int window_ms - Minimum time between flushes in milliseconds
+            std::function<void(long long)> send_client_lists - Sends client lists to clients behind the given version
+            std::function<void()> send_client_updates - Sends client updates to every server
+        */
+        PresenceScheduler(server* s, int window_ms, std::function<void(long long)> send_client_lists, std::function<void()> send_client_updates);
+
+        // Mark client lists as needing to be sent, returns the new client list version
+        long long markClientLists();
+
+        // Mark client updates as needing to be sent
+        void markClientUpdates();
+
+        // Returns the current client list version
+        long long currentVersion();
+};
+
+#endif
@@ -5,32 +5,48 @@ ServerList::ServerList(int server_id){
     // Set my server id
     my_server_id = server_id;
 
+    // Generate mapping file name, new clients are journalled next to it
+    std::string filename = "server-files/server_mapping";
+    filename.append(std::to_string(my_server_id));
+    mappingJournal.reset(new MappingJournal(filename + ".bin", filename + ".json", filename + ".journal"));
+
     load_mapping_from_file();
+    buildIndexes();
+}
+
+// Builds the server address index from serverAddresses
+void ServerList::buildIndexes(){
+    serverIDs.clear();
+    for(const auto& server: serverAddresses){
+        serverIDs[server.second] = server.first;
+    }
 }
 
 // Function to obtain server's public key from neighbourhood mapping
-EVP_PKEY* ServerList::getPKey(int server_id){
+KeyCache::Handle ServerList::getPKey(int server_id){
+    std::lock_guard<std::mutex> lock(listMutex);
     std::unordered_map<int, std::string>::const_iterator found_server = knownServers.find(server_id);
     if(found_server == knownServers.end()){
         std::cout << "Unknown Server" << std::endl;
-        return NULL;
+        return KeyCache::Handle();
     }
 
-    return Server_Key_Gen::stringToPEM(found_server->second);
+    return KeyCache::get(found_server->second);
 }
 
 // Obtain a server ID from the map using a provided server address
 int ServerList::ObtainID(std::string address){
-    for(const auto& server: serverAddresses){
-        if(server.second == address){
-            return server.first;
-        }
+    std::lock_guard<std::mutex> lock(listMutex);
+    auto server = serverIDs.find(address);
+    if(server == serverIDs.end()){
+        return -1;
     }
-    return -1;
+    return server->second;
 }
 
 // Obtain the uris of the other servers from the map
 std::unordered_map<int, std::string> ServerList::getUris(){
+    std::lock_guard<std::mutex> lock(listMutex);
     std::unordered_map<int, std::string> mapToReturn = serverAddresses;
 
     for(const auto& address: mapToReturn){
@@ -41,17 +57,44 @@ std::unordered_map<int, std::string> ServerList::getUris(){
     return mapToReturn;
 }
 
-// Saves the known users to a mapping file
-void ServerList::save_mapping_to_file() {
-    // Generate mapping file name
-    std::string filename = "server-files/server_mapping";
-    filename.append(std::to_string(my_server_id));
-    filename.append(".json");
+// Saves a new known user to the mapping file, the journal writes it on its own thread
+void ServerList::save_mapping_to_file(int client_id, const mapping_entry& entry) {
+    mappingJournal->append(client_id, entry);
+}
+
+// Also write the JSON mapping file alongside the binary snapshot
+void ServerList::exportMappingJson(bool enabled){
+    mappingJournal->setJsonExport(enabled);
+}
+
+// Evicts known clients over capacity, clients connected to this server are never evicted
+void ServerList::evictKnownClients(){
+    std::vector<int> evicted;
+    knownClients.evict([this](int client_id){ return currentClients.find(client_id) != currentClients.end(); }, evicted);
+    for(int client_id: evicted){
+        mappingJournal->remove(client_id);
+    }
+}
+
+void ServerList::setKnownClientCapacity(size_t capacity){
+    std::lock_guard<std::mutex> lock(listMutex);
+    knownClients.setCapacity(capacity);
+    evictKnownClients();
+}
+
+size_t ServerList::knownClientCount(){
+    std::lock_guard<std::mutex> lock(listMutex);
+    return knownClients.size();
+}
+
+size_t ServerList::evictedClientCount(){
+    std::lock_guard<std::mutex> lock(listMutex);
+    return knownClients.evictedCount();
+}
 
-    // Save the map to a file
-    nlohmann::json j_map = knownClients;
-    std::ofstream file(filename);
-    file << j_map.dump(4);
+size_t ServerList::skippedEvictionCount(){
+    std::lock_guard<std::mutex> lock(listMutex);
+    return knownClients.skippedCount();
 }
 
 // Reads the known users for this server from a mapping file
@@ -70,41 +113,36 @@ void ServerList::load_mapping_from_file(){
 
     knownServers = j_server_map.get<std::unordered_map<int, std::string>>();
 
-    // Generate mapping file name
-    filename = "server-files/server_mapping";
-    filename.append(std::to_string(my_server_id));
-    filename.append(".json");
+    // Server keys are kept for the lifetime of the server list so they are only parsed once
+    for(const auto& server: knownServers){
+        if(!server.second.empty()){
+            KeyCache::acquire(server.second);
+        }
+    }
 
-    // Load the map from file name
-    std::ifstream clientMapFile(filename);
+    // Load the map from the mapping file and the clients journalled since it was written
     // Check if file exists
-    if(!clientMapFile){
+    std::unordered_map<int, mapping_entry> loaded;
+    int largestID = 0;
+    if(!mappingJournal->load(loaded, largestID)){
         std::cout << "Server mapping file does not exist" << std::endl;
         return;
     }
+    knownClients.load(loaded);
 
-    // Parse file to JSON object
-    nlohmann::json j_client_map;
-    clientMapFile >> j_client_map;
-
-    // Convert JSON object to map and store
-    knownClients = j_client_map.get<std::unordered_map<int, std::string>>();
-
-    // Find and set last ID used so new clients get correct ID
-    int largestID=0;
-    for(const auto& client: knownClients){
-        if(client.first > largestID){
-            largestID = client.first;
-        }
-    }
+    // Set last ID used so new clients get correct ID, evicted clients' IDs are never given out again
     clientID = largestID;
 }
 
 // Retrieves all the clients for a server as a map
 std::unordered_map<int, std::string> ServerList::getClients(int server_id){
+    std::lock_guard<std::mutex> lock(listMutex);
     std::unordered_map<int, std::string> server;
-    if(servers.find(server_id) != servers.end()){
-        server = servers[server_id];
+    auto found = servers.find(server_id);
+    if(found != servers.end()){
+        for(const auto& client: found->second){
+            server[client.first] = *client.second;
+        }
     }
 
     return server;
@@ -112,12 +150,13 @@ std::unordered_map<int, std::string> ServerList::getClients(int server_id){
 
 // Retrieves a client's public key using its server and client ids
 std::pair<int, std::string> ServerList::retrieveClient(int server_id, int client_id) {
+    std::lock_guard<std::mutex> lock(listMutex);
     // Check if the server exists
     if (servers.find(server_id) != servers.end()) {
         // Check if the client exists in the server
         auto& client_list = servers[server_id];
         if (client_list.find(client_id) != client_list.end()) {
-            return {client_id, client_list[client_id]};
+            return {client_id, *client_list[client_id]};
         } else {
             throw std::runtime_error("Client ID not found.");
         }
@@ -126,85 +165,137 @@ std::pair<int, std::string> ServerList::retrieveClient(int server_id, int client
     }
 }
 
-// Retrieve the senders public key using their fingerprint (will be useful for signature verification on server)
-std::string ServerList::retrieveClientKey(int server_id, std::string fingerprint) {
+// Retrieve the senders public key using their fingerprint, empty if the server or fingerprint is unknown (called from message handlers, so it doesn't throw)
+std::string ServerList::retrieveClientKey(int server_id, const FingerprintDigest& fingerprint) {
+    std::lock_guard<std::mutex> lock(listMutex);
     // Check if the server exists
-    if (serversFingerprints.find(server_id) != serversFingerprints.end()) {
-        // Check if the fingerprint exists in the server
-        auto& client_list = serversFingerprints[server_id];
-        if (client_list.find(fingerprint) != client_list.end()) {
-            return client_list[fingerprint];
-        } else {
-            throw std::runtime_error("Fingerprint not found.");
-        }
-    } else {
-        throw std::runtime_error("Server ID not found.");
+    auto server = serversFingerprints.find(server_id);
+    if (server == serversFingerprints.end()) {
+        return "";
+    }
+    // Check if the fingerprint exists in the server
+    auto client = server->second.find(fingerprint);
+    if (client == server->second.end()) {
+        return "";
     }
+    return *client->second;
 }
 
 // Inserts a client to the list when a new connection is established
 int ServerList::insertClient(std::string public_key){
-    // Check list of known clients to see if client's public key matches one stored 
-    for(const auto& client: knownClients){
+    std::lock_guard<std::mutex> lock(listMutex);
+    // Check index of known clients to see if client's public key matches one stored
+    std::string digest = Sha256Hash::hashStringSha256(public_key);
+    long long now = (long long)std::time(nullptr);
+    KeyPool::Key key = KeyPool::intern(public_key);
+    int known_id = knownClients.find(digest, key);
+    if(known_id != -1){
         // If the client's public key matches, use previous ID
-        if(client.second  == public_key){
-            servers[my_server_id][client.first] = public_key;
 
-            std::string fingerprintString = Fingerprint::generateFingerprint(Server_Key_Gen::stringToPEM(public_key));
-            serversFingerprints[my_server_id][fingerprintString] = public_key;
-
-            currentClients[client.first] = public_key;
+        // Only take ownership of the key if the client isn't already in the list
+        if(servers[my_server_id].find(known_id) == servers[my_server_id].end()){
+            KeyCache::acquire(public_key);
+            listLog.record(my_server_id, known_id, key);
+            updateLog.record(my_server_id, known_id, key);
+            generation++;
+        }
+        servers[my_server_id][known_id] = key;
 
-            return client.first;
+        // Use the fingerprint stored in the mapping rather than working it out again
+        FingerprintDigest fingerprint = FingerprintDigest::fromText(knownClients.get(known_id)->fingerprint);
+        if(!fingerprint.valid()){
+            fingerprint = KeyCache::digest(public_key);
         }
+        serversFingerprints[my_server_id][fingerprint] = key;
+
+        currentClients[known_id] = key;
+
+        // Returning clients move to the back of the eviction order
+        knownClients.seen(known_id, now);
+        mappingJournal->seen(known_id, now);
+
+        return known_id;
     }
     // Otherwise create new client
     clientID++;
 
     // Add client to maps
-    servers[my_server_id][clientID] = public_key;
+    servers[my_server_id][clientID] = key;
+    KeyCache::acquire(public_key);
 
-    std::string fingerprintString = Fingerprint::generateFingerprint(Server_Key_Gen::stringToPEM(public_key));
-    serversFingerprints[my_server_id][fingerprintString] = public_key;
+    std::string fingerprintString = KeyCache::fingerprint(public_key);
+    serversFingerprints[my_server_id][KeyCache::digest(public_key)] = key;
     
-    currentClients[clientID] = public_key;
+    currentClients[clientID] = key;
+
+    listLog.record(my_server_id, clientID, key);
+    updateLog.record(my_server_id, clientID, key);
+    generation++;
 
     // Add new client to map of known clients and save new map to file
-    knownClients[clientID] = public_key;
+    mapping_entry entry;
+    entry.public_key = key;
+    entry.digest = digest;
+    entry.fingerprint = fingerprintString;
+    entry.last_seen = now;
+    save_mapping_to_file(clientID, knownClients.insert(clientID, entry));
 
-    // Untested function
-    //prune_client_list(my_server_id);
+    // Make room for the new client by evicting those not seen for longest
+    evictKnownClients();
 
-    save_mapping_to_file();
-    
     return clientID;
 }
 
 // Removes a client from the list when the connection is dropped
 void ServerList::removeClient(int client_id){
+    std::lock_guard<std::mutex> lock(listMutex);
     // Remove client from maps
-    std::string pubKey;
-    for(const auto& clients : servers[my_server_id]){
-        if(clients.first == client_id){
-            pubKey = clients.second;
-        }
+    FlatMap<int, KeyPool::Key>& myClients = servers[my_server_id];
+    auto client = myClients.find(client_id);
+    if(client == myClients.end()){
+        return;
     }
+    KeyPool::Key pubKey = client->second;
     
-    serversFingerprints[my_server_id].erase(Fingerprint::generateFingerprint(Server_Key_Gen::stringToPEM(pubKey)));
+    serversFingerprints[my_server_id].erase(KeyCache::digest(*pubKey));
 
-    servers[my_server_id].erase(client_id);
+    myClients.erase(client);
 
     currentClients.erase(client_id);
+
+    listLog.record(my_server_id, client_id, KeyPool::Key());
+    updateLog.record(my_server_id, client_id, KeyPool::Key());
+    generation++;
+
+    // Evict the client's key once it is no longer needed
+    KeyCache::release(*pubKey);
 }
 
 // Removes a server from the list
 void ServerList::removeServer(int server_id){
+    std::lock_guard<std::mutex> lock(listMutex);
+    // Release the keys of the server's clients
+    for(const auto& client: servers[server_id]){
+        KeyCache::release(*client.second);
+        listLog.record(server_id, client.first, KeyPool::Key());
+    }
     servers.erase(server_id);
     serversFingerprints.erase(server_id);
+    lastUpdates.erase(server_id);
+    updateVersions.erase(server_id);
+    generation++;
 }
 
 // Inserts or replaces a server in the list using a client update
+// Only clients that joined or left since the last update from the server are fingerprinted or removed
 void ServerList::insertServer(int server_id, std::string update){
+    std::lock_guard<std::mutex> lock(listMutex);
+    // Nothing to do if the update is identical to the last one received from this server
+    FingerprintDigest updateDigest = FingerprintDigest::fromHex(Sha256Hash::hashStringSha256(update));
+    auto lastUpdate = lastUpdates.find(server_id);
+    if(lastUpdate != lastUpdates.end() && lastUpdate->second == updateDigest){
+        return;
+    }
 
     // Convert string to JSON object
     nlohmann::json updatedServerJSON;
@@ -226,8 +317,6 @@ void ServerList::insertServer(int server_id, std::string update){
 
     std::unordered_map<int, std::string> updatedServer;
 
-    std::unordered_map<std::string, std::string> updatedServerFingerprints;
-
     for(const auto& client: clientsArray){
         if(client.contains("client-id") && client.contains("public-key")){
 
@@ -236,19 +325,201 @@ void ServerList::insertServer(int server_id, std::string update){
             return;
         }
         updatedServer[client["client-id"]] = client["public-key"];
-        std::string fingerprintString = Fingerprint::generateFingerprint(Server_Key_Gen::stringToPEM(client["public-key"]));
-        updatedServerFingerprints[fingerprintString] = client["public-key"];
     }
 
-    // Store map
-    servers[server_id] = updatedServer;
+    FlatMap<int, KeyPool::Key>& currentServer = servers[server_id];
+    FlatMap<FingerprintDigest, KeyPool::Key, FingerprintDigest::Hash>& currentFingerprints = serversFingerprints[server_id];
+
+    // Remove clients that have left or whose key has changed
+    for(auto client = currentServer.begin(); client != currentServer.end();){
+        auto updatedClient = updatedServer.find(client->first);
+        if(updatedClient == updatedServer.end() || updatedClient->second != *client->second){
+            currentFingerprints.erase(KeyCache::digest(*client->second));
+            KeyCache::release(*client->second);
+            listLog.record(server_id, client->first, KeyPool::Key());
+            client = currentServer.erase(client);
+        }else{
+            client++;
+        }
+    }
+
+    // Add clients that have joined, only their keys need to be parsed and fingerprinted
+    for(const auto& client: updatedServer){
+        if(currentServer.find(client.first) != currentServer.end()){
+            continue;
+        }
+        if(!KeyCache::acquire(client.second)){
+            continue;
+        }
+        KeyPool::Key key = KeyPool::intern(client.second);
+        currentServer[client.first] = key;
+        currentFingerprints[KeyCache::digest(client.second)] = key;
+        listLog.record(server_id, client.first, key);
+    }
+
+    // Store update to detect repeated updates
+    lastUpdates[server_id] = updateDigest;
+    generation++;
+
+    // Servers that send versions can send deltas from this update
+    if(updatedServerJSON.contains("version") && updatedServerJSON["version"].is_number_integer()){
+        updateVersions[server_id] = updatedServerJSON["version"].get<long long>();
+    }else{
+        updateVersions.erase(server_id);
+    }
+}
+
+// Applies the clients that joined or left a server since its last client update
+bool ServerList::insertServerDelta(int server_id, const std::string& delta){
+    std::lock_guard<std::mutex> lock(listMutex);
+    nlohmann::json deltaJSON;
+    try {
+        deltaJSON = nlohmann::json::parse(delta);
+    }catch (nlohmann::json::parse_error& e) {
+        std::cerr << "Invalid JSON format: " << e.what() << std::endl;
+        return false;
+    }
+
+    if(!deltaJSON.contains("from") || !deltaJSON.contains("version") || !deltaJSON["from"].is_number_integer() || !deltaJSON["version"].is_number_integer()){
+        std::cerr << "Invalid JSON" << std::endl;
+        return false;
+    }
+
+    // The delta has to follow on from the last update received from the server
+    auto lastVersion = updateVersions.find(server_id);
+    if(lastVersion == updateVersions.end() || lastVersion->second != deltaJSON["from"].get<long long>()){
+        return false;
+    }
+
+    FlatMap<int, KeyPool::Key>& currentServer = servers[server_id];
+    FlatMap<FingerprintDigest, KeyPool::Key, FingerprintDigest::Hash>& currentFingerprints = serversFingerprints[server_id];
+
+    // Remove clients that have left
+    if(deltaJSON.contains("removed") && deltaJSON["removed"].is_array()){
+        for(const auto& removed: deltaJSON["removed"]){
+            if(!removed.is_number_integer()){
+                continue;
+            }
+            auto client = currentServer.find(removed.get<int>());
+            if(client == currentServer.end()){
+                continue;
+            }
+            currentFingerprints.erase(KeyCache::digest(*client->second));
+            KeyCache::release(*client->second);
+            listLog.record(server_id, client->first, KeyPool::Key());
+            currentServer.erase(client);
+        }
+    }
+
+    // Add clients that have joined, replacing any with a different key
+    if(deltaJSON.contains("added") && deltaJSON["added"].is_array()){
+        for(const auto& added: deltaJSON["added"]){
+            if(!added.contains("client-id") || !added.contains("public-key")){
+                std::cerr << "Invalid JSON" << std::endl;
+                continue;
+            }
+            int client_id = added["client-id"];
+            std::string public_key = added["public-key"];
+
+            auto client = currentServer.find(client_id);
+            if(client != currentServer.end()){
+                if(*client->second == public_key){
+                    continue;
+                }
+                currentFingerprints.erase(KeyCache::digest(*client->second));
+                KeyCache::release(*client->second);
+                currentServer.erase(client);
+            }
+            if(!KeyCache::acquire(public_key)){
+                continue;
+            }
+            KeyPool::Key key = KeyPool::intern(public_key);
+            currentServer[client_id] = key;
+            currentFingerprints[KeyCache::digest(public_key)] = key;
+            listLog.record(server_id, client_id, key);
+        }
+    }
 
-    serversFingerprints[server_id] = updatedServerFingerprints;
+    updateVersions[server_id] = deltaJSON["version"].get<long long>();
+
+    // The last full update no longer matches the server's clients
+    lastUpdates.erase(server_id);
+    generation++;
+    return true;
 }
 
 // Creates a JSON client list of current connected network
 // Meant to be used for client_list
 std::string ServerList::exportClientList(){
+    std::lock_guard<std::mutex> lock(listMutex);
+    checkCache();
+
+    // Serialize JSON object once per change to the list
+    if(cachedClientList.empty()){
+        cachedClientList = buildClientList().dump();
+    }
+
+    return cachedClientList;
+}
+
+// Creates a client_list_delta of the clients that joined or left since a version, or the full client list if the version is too old
+std::string ServerList::exportClientList(long long since, long long& version){
+    std::lock_guard<std::mutex> lock(listMutex);
+    version = listLog.version();
+    checkCache();
+
+    std::vector<DirectoryLog::Change> changes;
+    if(since < 0 || !listLog.since(since, changes)){
+        if(cachedClientList.empty()){
+            cachedClientList = buildClientList().dump();
+        }
+        return cachedClientList;
+    }
+
+    auto cachedDelta = cachedListDeltas.find(since);
+    if(cachedDelta != cachedListDeltas.end()){
+        return cachedDelta->second;
+    }
+
+    nlohmann::json delta;
+    delta["type"] = "client_list_delta";
+    delta["from"] = since;
+    delta["version"] = version;
+
+    nlohmann::json added = nlohmann::json::array();
+    nlohmann::json removed = nlohmann::json::array();
+    for(const auto& change: changes){
+        nlohmann::json clientJSON;
+        clientJSON["server-id"] = change.server_id;
+        clientJSON["client-id"] = change.client_id;
+        if(!change.public_key){
+            removed.push_back(clientJSON);
+        }else{
+            clientJSON["address"] = serverAddresses[change.server_id];
+            clientJSON["public-key"] = *change.public_key;
+            added.push_back(clientJSON);
+        }
+    }
+    delta["added"] = added;
+    delta["removed"] = removed;
+
+    return cachedListDeltas[since] = delta.dump();
+}
+
+// Drops the cached exports if the list has changed since they were built, listMutex must be held
+void ServerList::checkCache(){
+    if(cachedGeneration == generation){
+        return;
+    }
+    cachedGeneration = generation;
+    cachedClientList.clear();
+    cachedUpdate.clear();
+    cachedListDeltas.clear();
+    cachedUpdateDeltas.clear();
+}
+
+// Builds the client list JSON object, listMutex must be held
+nlohmann::json ServerList::buildClientList(){
     // Create client list JSON object
     nlohmann::json clientList;
 
@@ -278,7 +549,7 @@ std::string ServerList::exportClientList(){
             
             // Modified this to be a given number as it needs to be a number for the client to store.
             clientsJSON["client-id"] = client.first;
-            clientsJSON["public-key"] = client.second;
+            clientsJSON["public-key"] = *client.second;
             
             // Push to array of clients of server
             serverClients.push_back(clientsJSON);
@@ -293,15 +564,70 @@ std::string ServerList::exportClientList(){
      // Add servers JSON array
     clientList["servers"] = serversJSON;
 
-    // Serialize JSON object
-    std::string json_string = clientList.dump();
+    // Peers that asked for deltas send them from this version
+    clientList["version"] = listLog.version();
 
-    return json_string;
+    return clientList;
 }
 
 // Creates a JSON list of clients currently connected to servers
 // Meant to be used for client_update
 std::string ServerList::exportUpdate(){
+    std::lock_guard<std::mutex> lock(listMutex);
+    checkCache();
+
+    // Serialize JSON object once per change to the list
+    if(cachedUpdate.empty()){
+        cachedUpdate = buildUpdate().dump();
+    }
+
+    return cachedUpdate;
+}
+
+// Creates a client_update_delta of the clients that joined or left since a version, or the full client update if the version is too old
+std::string ServerList::exportUpdate(long long since, long long& version){
+    std::lock_guard<std::mutex> lock(listMutex);
+    version = updateLog.version();
+    checkCache();
+
+    std::vector<DirectoryLog::Change> changes;
+    if(since < 0 || !updateLog.since(since, changes)){
+        if(cachedUpdate.empty()){
+            cachedUpdate = buildUpdate().dump();
+        }
+        return cachedUpdate;
+    }
+
+    auto cachedDelta = cachedUpdateDeltas.find(since);
+    if(cachedDelta != cachedUpdateDeltas.end()){
+        return cachedDelta->second;
+    }
+
+    nlohmann::json delta;
+    delta["type"] = "client_update_delta";
+    delta["from"] = since;
+    delta["version"] = version;
+
+    nlohmann::json added = nlohmann::json::array();
+    nlohmann::json removed = nlohmann::json::array();
+    for(const auto& change: changes){
+        if(!change.public_key){
+            removed.push_back(change.client_id);
+        }else{
+            nlohmann::json clientJSON;
+            clientJSON["client-id"] = change.client_id;
+            clientJSON["public-key"] = *change.public_key;
+            added.push_back(clientJSON);
+        }
+    }
+    delta["added"] = added;
+    delta["removed"] = removed;
+
+    return cachedUpdateDeltas[since] = delta.dump();
+}
+
+// Builds the client update JSON object, listMutex must be held
+nlohmann::json ServerList::buildUpdate(){
     // Create client list JSON object
     nlohmann::json clientUpdate;
 
@@ -315,36 +641,15 @@ std::string ServerList::exportUpdate(){
     for(const auto& client: currentClients){
         nlohmann::json clientJSON;
         clientJSON["client-id"] = client.first;
-        clientJSON["public-key"] = client.second;
+        clientJSON["public-key"] = *client.second;
 
         clientsArray.push_back(clientJSON);
     }
 
     clientUpdate["clients"] = clientsArray;
 
-    // Serialize JSON object
-    std::string json_string = clientUpdate.dump();
+    // Servers that asked for deltas send them from this version
+    clientUpdate["version"] = updateLog.version();
 
-    return json_string;
+    return clientUpdate;
 }
-
-/*void ServerList::prune_client_list(int server_id){
-    if(knownClients.size()<100)
-        return;
-
-    bool pruned = false;
-    for(const auto& currClient: knownClients){
-        auto found = currentClients.find(currClient.first);
-        if(found != currentClients.end()){
-            ServerList::removeClient(currClient.first);
-            pruned = true;
-        }
-    }
-    
-    if(!pruned){
-        auto first_in_list = knownClients.begin();
-        ServerList::removeClient(first_in_list->first);
-    }
-
-    return;
-}*/
\ No newline at end of file
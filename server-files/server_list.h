@@ -6,33 +6,75 @@
 #include <nlohmann/json.hpp> // For JSON library
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <memory>
+#include <ctime>
+#include <vector>
 
 #include "server_key_gen.h"
+#include "../client/Sha256Hash.h"
+#include "directory_log.h"
+#include "mapping_journal.h"
+#include "known_client_registry.h"
 #include "../client/Fingerprint.h"
+#include "../client/key_cache.h"
+#include "../client/key_pool.h"
+#include "../client/fingerprint_digest.h"
+#include "../client/flat_map.h"
 
 class ServerList{
     private:
     // Idea being that each server maps to another map, this ensure that we can access each server from their ID and each client from their server ID.
-        std::unordered_map<int, std::unordered_map<int, std::string>> servers; // Servers stored against their ID, map of clients stored against their IDs
-        std::unordered_map<int, std::unordered_map<std::string, std::string>> serversFingerprints; // Server stored aginst the ID, map of fingerprints stored against their public keys
+    // Public keys are interned in the KeyPool, every map holds a pointer to the one copy of each key.
+    // The maps are FlatMaps, so each server's clients are stored contiguously rather than one allocation per client.
+        FlatMap<int, FlatMap<int, KeyPool::Key>> servers; // Servers stored against their ID, map of clients stored against their IDs
+        FlatMap<int, FlatMap<FingerprintDigest, KeyPool::Key, FingerprintDigest::Hash>> serversFingerprints; // Server stored aginst the ID, map of public keys stored against their fingerprints
 
-        std::unordered_map<int, std::string> currentClients; // Clients currently connected to THIS server
-        std::unordered_map<int, std::string> knownClients; // Clients that belong to this server
+        FlatMap<int, KeyPool::Key> currentClients; // Clients currently connected to THIS server
+        KnownClientRegistry knownClients; // Clients that belong to this server, with their key digest and fingerprint, evicted once over capacity
         std::unordered_map<int, std::string> knownServers; // List of Servers with their Public Keys
+        std::unordered_map<int, FingerprintDigest> lastUpdates; // SHA-256 of the last client update received from each server
+        std::unordered_map<int, long long> updateVersions; // Version of the last client update received from each server, if it sent one
+
+        DirectoryLog listLog; // Changes to the client list (every server's clients)
+        DirectoryLog updateLog; // Changes to the client update (this server's current clients)
+
+        // Exports are serialised once and reused until the list changes
+        long long generation = 0; // Increased whenever servers or currentClients change
+        long long cachedGeneration = -1; // Generation the cached exports were built at
+        std::string cachedClientList;
+        std::string cachedUpdate;
+        std::unordered_map<long long, std::string> cachedListDeltas; // Client list deltas stored against the version they are from
+        std::unordered_map<long long, std::string> cachedUpdateDeltas; // Client update deltas stored against the version they are from
+        void checkCache();
 
         // Temporary way to store server addresses against their ID
         //Example std::unordered_map<int, std::string> serverAddresses = {{1, "127.0.0.1:9002"}, {2, "127.0.0.1:9003"}, {3, "127.0.0.1:9004"}};
         std::unordered_map<int, std::string> serverAddresses;
 
-        void save_mapping_to_file();
+        // Index kept in step with serverAddresses so lookups don't scan it (knownClients indexes itself)
+        std::unordered_map<std::string, int> serverIDs; // Server IDs stored against their address
+        void buildIndexes();
+
+        // Appends new known clients to the mapping file's journal off the server threads
+        std::unique_ptr<MappingJournal> mappingJournal;
+
+        void save_mapping_to_file(int client_id, const mapping_entry& entry);
         void load_mapping_from_file();
+        void evictKnownClients();
+
+        nlohmann::json buildClientList();
+        nlohmann::json buildUpdate();
 
         int my_server_id;
         int clientID=1000;
+
+        // Every public function holds this lock, so the list can be shared by every server thread
+        std::mutex listMutex;
     public:
         ServerList(int server_id);
 
-        EVP_PKEY* getPKey(int server_id);
+        KeyCache::Handle getPKey(int server_id);
         int ObtainID(std::string address);
 
         std::unordered_map<int, std::string> getUris();
@@ -40,19 +82,37 @@ class ServerList{
         std::unordered_map<int, std::string> getClients(int server_id);
 
         std::pair<int, std::string> retrieveClient(int server_id, int client_id);
-        std::string retrieveClientKey(int server_id, std::string fingerprint);
+        std::string retrieveClientKey(int server_id, const FingerprintDigest& fingerprint);
 
         int insertClient(std::string public_key);
         void removeClient(int client_id);
         void insertServer(int server_id, std::string update);
         void removeServer(int server_id);
 
+        /*
+            Applies a client_update_delta from a server. Returns false if the delta does not follow the last client update
+            received from the server, in which case a full client update should be requested.
+        */
+        bool insertServerDelta(int server_id, const std::string& delta);
+
         std::string exportUpdate();
         std::string exportClientList();
-        
-        /* This is untested, and wasn't meant to make it to the final submission. Leaving it commented out for the submission 
-           It was meant to remove clients from the server mapping after 100 had connected to prevent it from being flooded */
-        // void prune_client_list(int server_id);
+
+        // Also keep the JSON mapping file (server_mappingN.json) up to date whenever the binary snapshot is written
+        void exportMappingJson(bool enabled);
+
+        // Limits the number of known clients kept in the mapping, evicting the clients not seen for longest straight away if over it
+        void setKnownClientCapacity(size_t capacity);
+        size_t knownClientCount();
+        size_t evictedClientCount(); // Known clients evicted since the server started
+        size_t skippedEvictionCount(); // Times a connected client was passed over for eviction
+
+        /*
+            Exports a client_update_delta / client_list_delta of the changes after version since, or the full client update /
+            client list if since is negative or too old. version is set to the version of the exported directory.
+        */
+        std::string exportUpdate(long long since, long long& version);
+        std::string exportClientList(long long since, long long& version);
 };
 
 #endif
\ No newline at end of file
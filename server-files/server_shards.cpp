@@ -0,0 +1,82 @@
+#include "server_shards.h"
+
+ServerShards::ServerShards(server* s, int shard_count){
+    server_instance = s;
+
+    if(shard_count < 1){
+        shard_count = 1;
+    }
+
+    for(int i = 0; i < shard_count; i++){
+        std::unique_ptr<server_shard> shard(new server_shard());
+        shard->index = i;
+        shard->strand.reset(new websocketpp::lib::asio::io_service::strand(s->get_io_service()));
+        shards.push_back(std::move(shard));
+    }
+}
+
+int ServerShards::size(){
+    return (int)shards.size();
+}
+
+// Find the shard that owns a connection from the address of the connection
+server_shard& ServerShards::owner(websocketpp::connection_hdl hdl){
+    return owner(hdl.lock().get());
+}
+
+server_shard& ServerShards::owner(const void* connection){
+    uint64_t key = (uint64_t)reinterpret_cast<uintptr_t>(connection);
+
+    // Connections are allocated on aligned addresses, mix the bits so they spread evenly across shards
+    key *= 0x9E3779B97F4A7C15ULL;
+    return *shards[(key >> 32) % shards.size()];
+}
+
+void ServerShards::dispatch(websocketpp::connection_hdl hdl, std::function<void(server_shard&, connection_slot&)> handler){
+    // Hold the connection so its handle stays valid until the handler runs, this is the only time the handle is locked
+    server::connection_ptr connection = websocketpp::lib::static_pointer_cast<server::connection_type>(hdl.lock());
+    if(!connection){
+        return;
+    }
+
+    server_shard& shard = owner(connection.get());
+    shard.strand->post([&shard, connection, handler](){
+        handler(shard, *connection);
+    });
+}
+
+void ServerShards::broadcast(std::function<void(server_shard&)> handler){
+    for(const auto& shard: shards){
+        server_shard* target = shard.get();
+        target->strand->post([target, handler](){
+            handler(*target);
+        });
+    }
+}
+
+bool ServerShards::claim_server(int server_id){
+    std::lock_guard<std::mutex> lock(inbound_ids_mutex);
+    return inbound_server_ids.insert(server_id).second;
+}
+
+void ServerShards::release_server(int server_id){
+    std::lock_guard<std::mutex> lock(inbound_ids_mutex);
+    inbound_server_ids.erase(server_id);
+}
+
+void ServerShards::run(int thread_count){
+    std::vector<std::thread> threads;
+
+    // This thread runs the io_service too, so only start the extra threads
+    for(int i = 1; i < thread_count; i++){
+        threads.emplace_back([this](){
+            server_instance->run();
+        });
+    }
+
+    server_instance->run();
+
+    for(auto& thread: threads){
+        thread.join();
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef server_shards_h
+#define server_shards_h
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <unordered_set>
+
+#include "server_utilities.h"
+
+/*
+    A slice of the server's connections.
+    Each shard owns the connection maps for its connections and has a strand that every handler for those connections
+    runs on, so a shard's maps are only ever used by one thread at a time and need no locks.
+*/
+struct server_shard{
+    int index;
+    std::unique_ptr<websocketpp::lib::asio::io_service::strand> strand;
+
+    // Slots of this shard's connections, a connection keeps its slot in every map below until it closes
+    ConnectionSlots slots;
+
+    // Connections that have not sent a hello yet
+    connection_table connection_map;
+
+    // Map for connections made from clients -> this server
+    connection_table client_server_map;
+
+    // Slots of the shard's clients by the fingerprint of their key
+    client_fingerprint_table client_fingerprints;
+
+    // Map for connections made from other servers -> this server
+    connection_table inbound_server_server_map;
+};
+
+/*
+    Partitions the server's connections across shards and runs the server's io_service on a pool of threads.
+
+    A connection always belongs to the same shard. Work that has to reach connections owned by other shards (e.g.
+    broadcasting a chat to every client) is posted to each shard rather than touching another shard's maps, so
+    anything posted to other shards should be immutable (e.g. a message built once with make_framed_message()).
+
+    With one shard and one thread this behaves the same as running the server on a single thread.
+*/
+class ServerShards{
+    private:
+        server* server_instance;
+        std::vector<std::unique_ptr<server_shard>> shards;
+
+        server_shard& owner(const void* connection);
+
+        // IDs of servers with an inbound connection, shared by every shard to reject duplicate server connections
+        std::unordered_set<int> inbound_server_ids;
+        std::mutex inbound_ids_mutex;
+    public:
+        /*
+            server* s - Server instance, must have been initialised with init_asio()
+            int shard_count - Number of shards to partition connections across, at least one is always created
+        */
+        ServerShards(server* s, int shard_count);
+
+        int size();
+
+        // Returns the shard that owns a connection
+        server_shard& owner(websocketpp::connection_hdl hdl);
+
+        /*
+            Runs a handler on the shard that owns the connection.
+            Handlers for the same connection run in the order they were dispatched, and the connection is kept alive
+            until its handler has run. The handler is passed the connection's slot, the open handler gives it one from
+            the shard's ConnectionSlots and every later handler finds the connection in the shard's maps with it.
+        */
+        void dispatch(websocketpp::connection_hdl hdl, std::function<void(server_shard&, connection_slot&)> handler);
+
+        // Runs a handler on every shard
+        void broadcast(std::function<void(server_shard&)> handler);
+
+        /*
+            Records an inbound connection from a server.
+            Returns false if an inbound connection from the server already exists.
+        */
+        bool claim_server(int server_id);
+        void release_server(int server_id);
+
+        // Runs the server's io_service on thread_count threads, returns once the server has stopped
+        void run(int thread_count);
+};
+
+#endif
@@ -37,7 +37,7 @@ std::string ServerSignature::generateSignature(std::string message, EVP_PKEY *pr
 
 
 /* Verifies an encrypted signature against a decrypted message, provided the original message decoded and the encrypted string still Base64 encoded.*/
-bool ServerSignature::verifySignature(std::string encrypted_signature, std::string decrypted_message, EVP_PKEY* publicKey){
+bool ServerSignature::verifySignature(const std::string& encrypted_signature, const std::string& decrypted_message, EVP_PKEY* publicKey){
     std::string decoded_signature = Base64::decode(encrypted_signature);
     const unsigned char *combinedMessage = reinterpret_cast<const unsigned char*>(decoded_signature.c_str());
     std::string hashed_message = Sha256Hash::hashStringSha256(decrypted_message);
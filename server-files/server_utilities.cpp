@@ -1,9 +1,33 @@
 #include "server_utilities.h"
 
-ServerUtilities::ServerUtilities(const std::string uri){
+ServerUtilities::ServerUtilities(const std::string uri) :
+    frame_msg_manager(websocketpp::lib::make_shared<deflate_config::con_msg_manager_type>()),
+    frame_processor(false, true, frame_msg_manager, frame_rng){
     myUri = uri;
 };
 
+// Build an unframed text message, each connection frames (and masks) it when it is sent
+message_ptr ServerUtilities::make_message(const std::string& payload){
+    message_ptr message = frame_msg_manager->get_message(websocketpp::frame::opcode::text, payload.size());
+    message->append_payload(payload);
+    return message;
+}
+
+// Build a text message framed the way our server connections send it, so it is written as is to every client
+message_ptr ServerUtilities::make_framed_message(const std::string& payload){
+    message_ptr message = make_message(payload);
+    message_ptr framed = frame_msg_manager->get_message();
+
+    std::lock_guard<std::mutex> frame_lock(frame_mutex);
+    websocketpp::lib::error_code ec = frame_processor.prepare_data_frame(message, framed);
+    if(ec){
+        // Connections will frame the message themselves
+        LOG_WARN("Failed to frame message because: " << ec.message());
+        return message;
+    }
+    return framed;
+}
+
 // Find IP address + port number of connected client
 std::string ServerUtilities::getIP(server* s, websocketpp::connection_hdl hdl){
     // Get the remote endpoint (IP address and port)
@@ -69,295 +93,384 @@ int ServerUtilities::send_server_hello(client* c, websocketpp::connection_hdl hd
 
     // Send the message via the connection
     if(!is_connection_open(c, hdl)){
-        std::cout << "Connection is not open to send server hello" << std::endl;
+        LOG_WARN("Connection is not open to send server hello");
         return 1;
     }
     websocketpp::lib::error_code ec;
     c->send(hdl, message_string, websocketpp::frame::opcode::text, ec);
 
     if (ec) {
-        std::cout << "> Error sending server hello message: " << ec.message() << std::endl;
+        LOG_WARN("> Error sending server hello message: " << ec.message());
         return 1;
     } else {
-        std::cout << "> Server hello sent" << "\n" << std::endl;
+        LOG_INFO("> Server hello sent");
         return 0;
     }
 }
 
 // Send client update request to specified connection
-int ServerUtilities::send_client_update_request(client* c, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map){
+int ServerUtilities::send_client_update_request(client* c, int slot, const connection_table& outbound_server_server_map){
+    auto connection = outbound_server_server_map.find(slot);
+    if(connection == outbound_server_server_map.end()){
+        LOG_WARN("Connection is not open to send client update request");
+        return -1;
+    }
+    websocketpp::connection_hdl hdl = connection->second->connection_hdl;
+    int server_id = connection->second->server_id;
+
     nlohmann::json request;
     request["type"] = "client_update_request";
+    request["delta"] = true;
 
     // Serialize JSON object
     std::string json_string = request.dump();
 
     if(!is_connection_open(c, hdl)){
-        std::cout << "Connection is not open to send client update request" << std::endl;
+        LOG_WARN("Connection is not open to send client update request");
         return -1;
     }
 
     try {
         c->send(hdl, json_string, websocketpp::frame::opcode::text);
-        std::cout << "Sent client update request to server " << outbound_server_server_map[hdl]->server_id << std::endl;
+        LOG_DEBUG("Sent client update request to server " << server_id);
         return 0;
     } catch (const websocketpp::exception & e) {
-        std::cout << "Failed to send update request to server " << outbound_server_server_map[hdl]->server_id << " because: " << e.what() << std::endl;
+        LOG_WARN("Failed to send update request to server " << server_id << " because: " << e.what());
         return -1;
     }
 
 }
 
 // Send client update to specified connection
-int ServerUtilities::send_client_update(client* c, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, ServerList* global_server_list){
-    std::string json_string = global_server_list->exportUpdate();
+int ServerUtilities::send_client_update(client* c, int slot, const connection_table& outbound_server_server_map, ServerList* global_server_list){
+    long long version;
+    message_ptr message = make_message(global_server_list->exportUpdate(-1, version));
+
+    // Later updates to the server can be deltas from this version
+    auto connection = outbound_server_server_map.find(slot);
+    if(connection != outbound_server_server_map.end()){
+        connection->second->directory_version = version;
+    }
+    return send_client_update(c, slot, outbound_server_server_map, message);
+}
 
-    if(!is_connection_open(c, hdl)){
-        std::cout << "Connection is not open to send client update to server " << outbound_server_server_map[hdl]->server_id << std::endl;
+// Send an already built client update to specified connection
+int ServerUtilities::send_client_update(client* c, int slot, const connection_table& outbound_server_server_map, const message_ptr& message){
+    auto connection = outbound_server_server_map.find(slot);
+    if(connection == outbound_server_server_map.end()){
+        LOG_WARN("Connection is not open to send client update");
+        return -1;
+    }
+    int server_id = connection->second->server_id;
+
+    if(!is_connection_open(c, connection->second->connection_hdl)){
+        LOG_WARN("Connection is not open to send client update to server " << server_id);
         return -1;
     }
 
     try {
-        c->send(hdl, json_string, websocketpp::frame::opcode::text);
-        std::cout << "Sent client update to server " << outbound_server_server_map[hdl]->server_id << std::endl;
+        c->send(connection->second->connection_hdl, message);
+        LOG_DEBUG("Sent client update to server " << server_id);
         return 0;
     } catch (const websocketpp::exception & e) {
-        std::cout << "Failed to send client update to " << outbound_server_server_map[hdl]->server_id << " because: " << e.what() << std::endl;
+        LOG_WARN("Failed to send client update to " << server_id << " because: " << e.what());
         return -1;
     }
 }
 
 // Send client updates to all servers but the one specified (if specified)
-void ServerUtilities::broadcast_client_updates(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, ServerList* global_server_list, int server_id_nosend){
+void ServerUtilities::broadcast_client_updates(const connection_table& outbound_server_server_map, ServerList* global_server_list, int server_id_nosend){
+    // Export the update once and share it between every server
+    long long version;
+    message_ptr message = make_message(global_server_list->exportUpdate(-1, version));
+
+    // Deltas are built once for each version servers were last sent
+    std::unordered_map<long long, std::pair<message_ptr, long long>> deltas;
+
     // Broadcast client_updates
     for(const auto& connectPair: outbound_server_server_map){
-        auto connection = connectPair.second;
-        if(connection->server_id != server_id_nosend){
-            send_client_update(connection->client_instance, connection->connection_hdl, outbound_server_server_map, global_server_list);
+        const auto& connection = connectPair.second;
+        if(connection->server_id == server_id_nosend){
+            continue;
+        }
+
+        if(connection->delta && connection->directory_version >= 0){
+            auto delta = deltas.find(connection->directory_version);
+            if(delta == deltas.end()){
+                long long deltaVersion;
+                message_ptr deltaMessage = make_message(global_server_list->exportUpdate(connection->directory_version, deltaVersion));
+                delta = deltas.emplace(connection->directory_version, std::make_pair(deltaMessage, deltaVersion)).first;
+            }
+
+            // Nothing has changed since the server's last update
+            if(delta->second.second == connection->directory_version){
+                continue;
+            }
+            send_client_update(connection->client_instance, connection->slot, outbound_server_server_map, delta->second.first);
+            connection->directory_version = delta->second.second;
+        }else{
+            send_client_update(connection->client_instance, connection->slot, outbound_server_server_map, message);
+            connection->directory_version = version;
         }
     }
 }
 
 // Send client list to specified connection
-int ServerUtilities::send_client_list(server* s, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, ServerList* global_server_list){
-    std::string json_string = global_server_list->exportClientList();
+int ServerUtilities::send_client_list(server* s, int slot, const connection_table& client_server_map, ServerList* global_server_list){
+    return send_client_list(s, slot, client_server_map, make_framed_message(global_server_list->exportClientList()));
+}
+
+// Send an already built client list to specified connection
+int ServerUtilities::send_client_list(server* s, int slot, const connection_table& client_server_map, const message_ptr& message){
+    auto connection = client_server_map.find(slot);
+    if(connection == client_server_map.end()){
+        LOG_WARN("Connection is not open to send client list");
+        return -1;
+    }
 
     try {
-        s->send(hdl, json_string, websocketpp::frame::opcode::text);
-        std::cout << "Sent client list to client " << client_server_map[hdl]->client_id <<  std::endl;
+        s->send(connection->second->connection_hdl, message);
+        LOG_DEBUG("Sent client list to client " << connection->second->client_id);
         return 0;
     } catch (const websocketpp::exception & e) {
-        std::cout << "Failed to send client list because: " << e.what() << std::endl;
+        LOG_WARN("Failed to send client list because: " << e.what());
         return -1;
     }
 }
 
 // Send client lists to all clients but one specified (if specified)
-void ServerUtilities::broadcast_client_lists(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, ServerList* global_server_list, int client_id_nosend){
+void ServerUtilities::broadcast_client_lists(const connection_table& client_server_map, ServerList* global_server_list, int client_id_nosend){
+    // Export and frame the list once and share it between every client
+    broadcast_client_lists(client_server_map, make_framed_message(global_server_list->exportClientList()), client_id_nosend);
+}
+
+// Send an already built client list to all clients but one specified (if specified)
+void ServerUtilities::broadcast_client_lists(const connection_table& client_server_map, const message_ptr& message, int client_id_nosend){
     for(const auto& connectPair: client_server_map){
-        auto connection = connectPair.second;
+        const auto& connection = connectPair.second;
         if(connection->client_id != client_id_nosend){
-            send_client_list(connection->server_instance, connection->connection_hdl, client_server_map, global_server_list);
+            send_client_list(connection->server_instance, connection->slot, client_server_map, message);
+        }
+    }
+}
+
+// Send an already built client list to clients that have an older version, or a delta to clients that asked for them
+void ServerUtilities::update_client_lists(const connection_table& client_server_map, ServerList* global_server_list, const message_ptr& message, long long directory_version, long long version){
+    // Deltas are built once for each version clients were last sent
+    std::unordered_map<long long, std::pair<message_ptr, long long>> deltas;
+
+    for(const auto& connectPair: client_server_map){
+        const auto& connection = connectPair.second;
+        if(connection->list_version >= version){
+            continue;
+        }
+        connection->list_version = version;
+
+        if(connection->delta && connection->directory_version >= 0){
+            auto delta = deltas.find(connection->directory_version);
+            if(delta == deltas.end()){
+                long long deltaVersion;
+                message_ptr deltaMessage = make_framed_message(global_server_list->exportClientList(connection->directory_version, deltaVersion));
+                delta = deltas.emplace(connection->directory_version, std::make_pair(deltaMessage, deltaVersion)).first;
+            }
+
+            // Nothing has changed since the client's last list
+            if(delta->second.second == connection->directory_version){
+                continue;
+            }
+            send_client_list(connection->server_instance, connection->slot, client_server_map, delta->second.first);
+            connection->directory_version = delta->second.second;
+        }else{
+            send_client_list(connection->server_instance, connection->slot, client_server_map, message);
+            connection->directory_version = directory_version;
         }
     }
 }
 
 // Send public chat to connection
-int ServerUtilities::send_public_chat_server(client* c, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, std::string message){
+int ServerUtilities::send_public_chat_server(client* c, int slot, const connection_table& outbound_server_server_map, const message_ptr& message){
+    auto connection = outbound_server_server_map.find(slot);
+    if(connection == outbound_server_server_map.end()){
+        LOG_WARN("Connection is not open to send public chat");
+        return -1;
+    }
+    int server_id = connection->second->server_id;
 
-    if(!is_connection_open(c, hdl)){
-        std::cout << "Connection is not open to send public chat to server " << outbound_server_server_map[hdl]->server_id << std::endl;
+    if(!is_connection_open(c, connection->second->connection_hdl)){
+        LOG_WARN("Connection is not open to send public chat to server " << server_id);
         return -1;
     }
 
     try {
-        c->send(hdl, message, websocketpp::frame::opcode::text);
-        std::cout << "Sent public chat to server " << outbound_server_server_map[hdl]->server_id << std::endl;
+        c->send(connection->second->connection_hdl, message);
+        LOG_DEBUG("Sent public chat to server " << server_id);
         return 0;
     } catch (const websocketpp::exception & e) {
-        std::cout << "Failed to send public chat to server " << outbound_server_server_map[hdl]->server_id << " because: " << e.what() << std::endl;
+        LOG_WARN("Failed to send public chat to server " << server_id << " because: " << e.what());
         return -1;
     }
 }
 
 // Send public chat to all servers but specified server
-void ServerUtilities::broadcast_public_chat_servers(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, std::string message, int server_id_nosend){
+void ServerUtilities::broadcast_public_chat_servers(const connection_table& outbound_server_server_map, const std::string& message, int server_id_nosend){
+    message_ptr shared_message = make_message(message);
+
     for(const auto& connectPair: outbound_server_server_map){
-        auto connection = connectPair.second;
+        const auto& connection = connectPair.second;
         if(connection->server_id != server_id_nosend){
-            send_public_chat_server(connection->client_instance, connection->connection_hdl, outbound_server_server_map, message);
+            send_public_chat_server(connection->client_instance, connection->slot, outbound_server_server_map, shared_message);
         }
     }
 }
 
 // Send public chat to connection
-int ServerUtilities::send_public_chat_client(server* s, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, std::string message){
-    // Check if connection is open before sending
+int ServerUtilities::send_public_chat_client(server* s, int slot, const connection_table& client_server_map, const message_ptr& message){
+    auto connection = client_server_map.find(slot);
+    if(connection == client_server_map.end()){
+        LOG_WARN("Connection is not open to send public chat");
+        return -1;
+    }
+    int client_id = connection->second->client_id;
 
     try {
-        s->send(hdl, message, websocketpp::frame::opcode::text);
-        std::cout << "Sent public chat to client " << client_server_map[hdl]->client_id << std::endl;
+        s->send(connection->second->connection_hdl, message);
+        LOG_DEBUG("Sent public chat to client " << client_id);
         return 0;
     } catch (const websocketpp::exception & e) {
-        std::cout << "Failed to send public chat to client " << client_server_map[hdl]->client_id << " because: " << e.what() << std::endl;
+        LOG_WARN("Failed to send public chat to client " << client_id << " because: " << e.what());
         return -1;
     }
 }
 
 // Send public chat to all clients but specified client (if specified)
-void ServerUtilities::broadcast_public_chat_clients(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, std::string message, int client_id_nosend){
+void ServerUtilities::broadcast_public_chat_clients(const connection_table& client_server_map, const std::string& message, int client_id_nosend){
+    broadcast_public_chat_clients(client_server_map, make_framed_message(message), client_id_nosend);
+}
+
+// Send an already built public chat to all clients but specified client (if specified)
+void ServerUtilities::broadcast_public_chat_clients(const connection_table& client_server_map, const message_ptr& message, int client_id_nosend){
     for(const auto& connectPair: client_server_map){
-        auto connection = connectPair.second;
+        const auto& connection = connectPair.second;
         if(connection->client_id != client_id_nosend){
-            send_public_chat_client(connection->server_instance, connection->connection_hdl, client_server_map, message);
+            send_public_chat_client(connection->server_instance, connection->slot, client_server_map, message);
         }
     }
 }
 
 // Send private chat to connection
-int ServerUtilities::send_private_chat_server(client* c, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, std::string message){
+int ServerUtilities::send_private_chat_server(client* c, int slot, const connection_table& outbound_server_server_map, const message_ptr& message){
+    auto connection = outbound_server_server_map.find(slot);
+    if(connection == outbound_server_server_map.end()){
+        LOG_WARN("Connection is not open to send private chat");
+        return -1;
+    }
+    int server_id = connection->second->server_id;
 
-    if(!is_connection_open(c, hdl)){
-        std::cout << "Connection is not open to send private chat to server " << outbound_server_server_map[hdl]->server_id << std::endl;
+    if(!is_connection_open(c, connection->second->connection_hdl)){
+        LOG_WARN("Connection is not open to send private chat to server " << server_id);
         return -1;
     }
 
     try {
-        c->send(hdl, message, websocketpp::frame::opcode::text);
-        std::cout << "Sent private chat to server " << outbound_server_server_map[hdl]->server_id << std::endl;
+        c->send(connection->second->connection_hdl, message);
+        LOG_DEBUG("Sent private chat to server " << server_id);
         return 0;
     } catch (const websocketpp::exception & e) {
-        std::cout << "Failed to send private chat to server " << outbound_server_server_map[hdl]->server_id << " because: " << e.what() << std::endl;
+        LOG_WARN("Failed to send private chat to server " << server_id << " because: " << e.what());
         return -1;
     }
 }
 
 // Send private chat to all required servers
-void ServerUtilities::broadcast_private_chat_servers(std::unordered_set<std::string> serverSet, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, std::string message){
+void ServerUtilities::broadcast_private_chat_servers(const std::unordered_set<std::string>& serverSet, const connection_table& outbound_server_server_map, const std::string& message){
+    message_ptr shared_message = make_message(message);
+
+    // Each destination is found from its address, the outbound connections aren't searched
     for(const auto& address : serverSet){
-        for(const auto& connectPair : outbound_server_server_map){
-            auto connection = connectPair.second;
-            std::string serverAddress = connection->server_address.substr(5, (connection->server_address.length()-5));
-            
-            if(serverAddress == address){
-                send_private_chat_server(connection->client_instance, connection->connection_hdl, outbound_server_server_map, message);
-            }
+        auto connection = outbound_server_server_map.find(outbound_links.find(address));
+        if(connection != outbound_server_server_map.end()){
+            send_private_chat_server(connection->second->client_instance, connection->first, outbound_server_server_map, shared_message);
         }
     }
 }
 
 // Send private chat to client
-int ServerUtilities::send_private_chat_client(server* s, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, std::string message){
-    // Check if connection is open before sending
+int ServerUtilities::send_private_chat_client(server* s, int slot, const connection_table& client_server_map, const message_ptr& message){
+    auto connection = client_server_map.find(slot);
+    if(connection == client_server_map.end()){
+        LOG_WARN("Connection is not open to send private chat");
+        return -1;
+    }
+    int client_id = connection->second->client_id;
 
     try {
-        s->send(hdl, message, websocketpp::frame::opcode::text);
-        std::cout << "Sent private chat to client " << client_server_map[hdl]->client_id << std::endl;
+        s->send(connection->second->connection_hdl, message);
+        LOG_DEBUG("Sent private chat to client " << client_id);
         return 0;
     } catch (const websocketpp::exception & e) {
-        std::cout << "Failed to send private chat to client " << client_server_map[hdl]->client_id << " because: " << e.what() << std::endl;
+        LOG_WARN("Failed to send private chat to client " << client_id << " because: " << e.what());
         return -1;
     }
 }
 
 // Send private chat to all clients but specified client (if specified)
-void ServerUtilities::broadcast_private_chat_clients(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, std::string message, int client_id_nosend){
+void ServerUtilities::broadcast_private_chat_clients(const connection_table& client_server_map, const std::string& message, int client_id_nosend){
+    broadcast_private_chat_clients(client_server_map, make_framed_message(message), client_id_nosend);
+}
+
+// Send an already built private chat to all clients but specified client (if specified)
+void ServerUtilities::broadcast_private_chat_clients(const connection_table& client_server_map, const message_ptr& message, int client_id_nosend){
     for(const auto& connectPair: client_server_map){
-        auto connection = connectPair.second;
+        const auto& connection = connectPair.second;
         if(connection->client_id != client_id_nosend){
-            send_private_chat_client(connection->server_instance, connection->connection_hdl, client_server_map, message);
+            send_private_chat_client(connection->server_instance, connection->slot, client_server_map, message);
         }
     }
 }
 
-// Define a function that will handle the client connections retry logic
-void ServerUtilities::connect_to_server(client* c, std::string const & uri, int server_id, EVP_PKEY* private_key, int counter, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal>* outbound_server_server_map, std::mutex* outbound_map_mutex, int retry_attempts) {
-    std::lock_guard<std::mutex> map_lock(*outbound_map_mutex);
-    for(const auto& connection: *outbound_server_server_map){
-        if(connection.second->server_id == server_id){
-            std::cout << "Outbound connection already exists to server " << server_id << std::endl;
-            return;
+// Send an already built private chat to each of its recipients that is a client of this map, but the specified client (if specified)
+void ServerUtilities::send_private_chat_recipients(const connection_table& client_server_map, const client_fingerprint_table& client_fingerprints, const message_ptr& message, const std::vector<FingerprintDigest>& recipients, int client_id_nosend){
+    for(const auto& recipient: recipients){
+        auto slot = client_fingerprints.find(recipient);
+        if(slot == client_fingerprints.end()){
+            continue;
         }
-    }
-    
-    websocketpp::lib::error_code ec;
-    client::connection_ptr con = c->get_connection(uri, ec);
-
-    if (ec) {
-        std::cout << "Could not create connection because: " << ec.message() << std::endl;
-        return;
-    }
-
-    // Set fail handler to retry if connection fails
-    con->set_fail_handler([this, c, uri, server_id, private_key, counter, outbound_server_server_map, outbound_map_mutex, retry_attempts](websocketpp::connection_hdl hdl) {
-        std::cout << "Connection to " << uri << " failed, retrying in 500ms..." << std::endl;
-
-        // Retry after 500ms
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        if (retry_attempts < 10) { 
-            connect_to_server(c, uri, server_id, private_key, counter, outbound_server_server_map, outbound_map_mutex, retry_attempts + 1);
-        } else {
-            std::cout << "Exceeded retry limit. Giving up on connecting to " << uri << std::endl;
-        }
-    });
-
-    // Set open handler when connection succeeds
-    con->set_open_handler([this, c, uri, server_id, private_key, counter, outbound_server_server_map, outbound_map_mutex](websocketpp::connection_hdl hdl) {
-        std::cout << "\nSuccessfully connected to " << uri << std::endl;
-
-        send_server_hello(c, hdl, private_key, counter);
-        
-        std::lock_guard<std::mutex> map_lock(*outbound_map_mutex);
-        auto con_data = std::make_shared<connection_data>();
-        con_data->client_instance = c;
-        con_data->connection_hdl = hdl;
-        con_data->server_address = uri;
-        con_data->server_id = server_id;
-
-        // Add connection data to outbound connection map
-        (*outbound_server_server_map)[hdl] = con_data;
-
-        // Has to be here, cannot be earlier otherwise a segmentation fault occurs
-        send_client_update_request(c, hdl, *outbound_server_server_map);
-    });
-
-    // Handler for when another server closes connection
-    con->set_close_handler([this, c, uri, server_id, private_key, counter, outbound_server_server_map, outbound_map_mutex](websocketpp::connection_hdl hdl) {
-        std::cout << "\nServer " << server_id << " closing outbound connection" << std::endl;
-
-        // Erase connection from outbound connection map
-        std::lock_guard<std::mutex> map_lock(*outbound_map_mutex);
-        if(outbound_server_server_map->find(hdl) != outbound_server_server_map->end()){
-            outbound_server_server_map->erase(hdl);
+        auto connection = client_server_map.find(slot->second);
+        if(connection != client_server_map.end() && connection->second->client_id != client_id_nosend){
+            send_private_chat_client(connection->second->server_instance, slot->second, client_server_map, message);
         }
-
-        // Get connection pointer from the connection handle
-        client::connection_ptr con = c->get_con_from_hdl(hdl);
-
-        // Extract the close reason and close code
-        if(con->get_remote_close_reason() != "Server signature could not be verified."){
-            // Attempt to reconnect
-            std::cout << "Trying to reconnect to server " << server_id << std::endl;
-            connect_to_server(c, uri, server_id, private_key, counter, outbound_server_server_map, outbound_map_mutex);
-        }else{
-            std::cout << "Invalid signature sent in hello" << std::endl;
-            return;
-        }
-    });
-
-    // Try to connect to the server
-    c->connect(con);
+    }
 }
 
-std::time_t ServerUtilities::current_time(){
-        // Generate current time
-    std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
-    std::time_t convTime = std::chrono::system_clock::to_time_t(now);
+// Give an outbound connection that has opened a slot and add its connection data to the outbound connection map
+int ServerUtilities::add_outbound(client* c, websocketpp::connection_hdl hdl, const std::string& uri, int server_id, connection_table& outbound_server_server_map){
+    auto con_data = std::make_shared<connection_data>();
+    con_data->client_instance = c;
+    con_data->connection_hdl = hdl;
+    con_data->server_address = uri;
+    con_data->server_id = server_id;
 
-    // Convert to GMT time and time structure
-    std::tm* utc_tm = std::gmtime(&convTime);
+    client::connection_ptr con = c->get_con_from_hdl(hdl);
+    con->slot = outbound_slots.acquire();
+    con_data->slot = con->slot;
+    outbound_server_server_map[con_data->slot] = con_data;
+    outbound_links.add(server_id, uri, con_data->slot);
+    return con_data->slot;
+}
 
-    auto timepoint = std::mktime(utc_tm);
+// Erase a closed outbound connection from the outbound connection map and free its slot
+void ServerUtilities::remove_outbound(client* c, websocketpp::connection_hdl hdl, connection_table& outbound_server_server_map){
+    client::connection_ptr con = c->get_con_from_hdl(hdl);
+    auto connection = outbound_server_server_map.find(con->slot);
+    if(connection == outbound_server_server_map.end()){
+        return;
+    }
+    outbound_links.remove(connection->second->server_id, connection->second->server_address, con->slot);
+    outbound_server_server_map.erase(connection);
+    outbound_slots.release(con->slot);
+    con->slot = -1;
+}
 
-    return timepoint;
+int ServerUtilities::outbound_slot(int server_id){
+    return outbound_links.find(server_id);
 }
\ No newline at end of file
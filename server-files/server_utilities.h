@@ -7,6 +7,7 @@
 #include <websocketpp/config/debug_asio_no_tls.hpp>
 #include <websocketpp/server.hpp>
 #include <websocketpp/extensions/permessage_deflate/enabled.hpp>
+#include <websocketpp/processors/hybi13.hpp>
 
 #include <nlohmann/json.hpp> // For JSON library
 
@@ -16,10 +17,17 @@
 
 #include <unordered_set>
 #include <mutex>
+#include <deque>
+#include <functional>
 
 #include "server_signature.h"
 #include "server_key_gen.h"
+#include "connection_slots.h"
+#include "link_index.h"
 #include "../client/Fingerprint.h"
+#include "../client/fingerprint_digest.h"
+#include "../client/flat_map.h"
+#include "../client/logger.h"
 #include "server_list.h"
 
 struct deflate_config : public websocketpp::config::debug_core {
@@ -39,6 +47,9 @@ struct deflate_config : public websocketpp::config::debug_core {
     typedef base::elog_type elog_type;
     
     typedef base::rng_type rng_type;
+
+    // Connections carry their slot in the shard's connection tables
+    typedef connection_slot connection_base;
     
     struct transport_config : public base::transport_config {
         typedef type::concurrency_type concurrency_type;
@@ -63,41 +74,85 @@ struct deflate_config : public websocketpp::config::debug_core {
 typedef websocketpp::server<deflate_config> server;
 typedef server::message_ptr message_ptr;
 
-// WebSocket++ client configuration
-typedef websocketpp::client<websocketpp::config::asio_client> client;
+// WebSocket++ client configuration, outbound connections carry their slot in the outbound connection table
+struct slot_client_config : public websocketpp::config::asio_client {
+    typedef slot_client_config type;
+    typedef connection_slot connection_base;
+};
+typedef websocketpp::client<slot_client_config> client;
 
 // Data structure to manage connections and their timers
 struct connection_data{
     server* server_instance;
     client* client_instance;
     websocketpp::connection_hdl connection_hdl;
+    int slot = -1; // Key of the connection in its connection tables, see connection_slot
     server::timer_ptr timer;
     std::string server_address;
-    int client_id;
-    int server_id;
-};
-
-// Functions used to hash connection_hdl's
-struct connection_hdl_hash {
-    std::size_t operator()(websocketpp::connection_hdl hdl) const {
-        return std::hash<uintptr_t>()(reinterpret_cast<uintptr_t>(hdl.lock().get()));
-    }
-};
-struct connection_hdl_equal {
-    bool operator()(websocketpp::connection_hdl a, websocketpp::connection_hdl b) const {
-        return a.lock() == b.lock();
+    int client_id = 0;
+    int server_id = 0;
+    FingerprintDigest fingerprint; // Fingerprint of a client's public key
+    long long list_version = 0; // Version of the client list a client was last sent (see PresenceScheduler)
+    bool delta = false; // The peer asked for client_list_delta / client_update_delta messages
+    long long directory_version = -1; // ServerList version of the client list or client update last sent to the peer
+
+    // Only used on the shard that owns the connection
+    bool verifying = false; // A signature from this connection is being verified
+    bool closed = false; // The connection has closed, messages still being verified are dropped
+    std::deque<std::function<void()>> pending_messages; // Messages received while a signature was being verified
+
+    /*
+        Whether a message received on the connection has to wait in pending_messages for the signature being verified.
+        A client_list_request only waits for the client's hello, once the client is in the client_server_map it is
+        answered straight away rather than behind the client's signed messages.
+    */
+    bool waits_for_verification(const nlohmann::json& message, bool confirmed_client) const {
+        if(!verifying){
+            return false;
+        }
+        bool client_list_request = message.is_object() && message.contains("type") && message["type"] == "client_list_request";
+        return !(client_list_request && confirmed_client);
     }
 };
 
+// Connections stored against their slot, a connection is found by indexing an array rather than hashing its handle
+typedef SlotTable<std::shared_ptr<connection_data>> connection_table;
+
+// Slots of client connections stored against the fingerprint of the client's key, used to deliver private chats to their recipients
+typedef FlatMap<FingerprintDigest, int, FingerprintDigest::Hash> client_fingerprint_table;
+
 
 
 class ServerUtilities{
     private:
         // Stores the server's URI when instantiated as an object
         std::string myUri;
+
+        // Used to build messages once so they can be shared between every connection they are sent to
+        deflate_config::rng_type frame_rng;
+        deflate_config::con_msg_manager_type::ptr frame_msg_manager;
+        websocketpp::processor::hybi13<deflate_config> frame_processor;
+        std::mutex frame_mutex;
+
+        // Slots of outbound connections and the outbound connection to each server, only used with the outbound map's mutex held
+        ConnectionSlots outbound_slots;
+        LinkIndex outbound_links;
     public:
         ServerUtilities(const std::string uri);
 
+        /*
+            Builds a text message that can be queued to any number of connections without copying the payload.
+
+            make_message() builds an unframed message, used for outbound (server-server) connections which must
+            mask every frame they send, so each connection frames its own copy.
+            make_framed_message() frames the message once, server connections do not mask frames so the same frame is
+            written as is to every client it is sent to.
+
+            std::string payload - String to send, this should be the received bytes when forwarding a message
+        */
+        message_ptr make_message(const std::string& payload);
+        message_ptr make_framed_message(const std::string& payload);
+
         std::string getIP(server* s, websocketpp::connection_hdl hdl);
 
         bool is_connection_open(client* c, websocketpp::connection_hdl hdl);
@@ -134,16 +189,18 @@ class ServerUtilities{
             This message is sent to all servers that a connection is established with.
 
             {
-                "type": "client_update_request"
+                "type": "client_update_request",
+                "delta": true
             }
             This is NOT signed and does NOT follow the data format.
+            "delta" asks for client_update_delta messages after the first client update, servers that don't support
+            them ignore it and keep sending full client updates.
 
             client* c - Client instance of server-server connection
-            websocketpp::connection_hdl hdl - Connection handle of server-server connection
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            outbound_server_server_map - Map of outbound connections 
+            int slot - Slot of the server-server connection in outbound_server_server_map
+            connection_table outbound_server_server_map - Map of outbound connections 
         */
-        int send_client_update_request(client* c, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map);
+        int send_client_update_request(client* c, int slot, const connection_table& outbound_server_server_map);
         
         /*
             Client Update
@@ -157,28 +214,45 @@ class ServerUtilities{
                         "client-id":"<client-id>",
                         "public-key":"<public-key>"
                     },
-                ]
+                ],
+                "version": <version>
             }
             This is NOT signed and does NOT follow the data format.
+            The client update is recorded as the version sent to the server, so later updates can be sent as deltas.
 
             client* c - Client instance of server-server connection
-            websocketpp::connection_hdl hdl - Connection handle of server-server connection
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            outbound_server_server_map - Map of outbound connections
+            int slot - Slot of the server-server connection in outbound_server_server_map
+            connection_table outbound_server_server_map - Map of outbound connections
             ServerList* global_server_list - Pointer to server's ServerList object to generate client update JSON
+            message_ptr message - Client update built with make_message(), used instead of global_server_list when broadcasting
         */
-        int send_client_update(client* c, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, ServerList* global_server_list);
+        int send_client_update(client* c, int slot, const connection_table& outbound_server_server_map, ServerList* global_server_list);
+        int send_client_update(client* c, int slot, const connection_table& outbound_server_server_map, const message_ptr& message);
         
         /*
             Calls send_client_update() function for all servers except the one specified (if provided in call).
+            The update is exported once and the same message is sent to every server.
+            Servers that asked for deltas are sent only the clients that joined or left since their last update instead:
+
+            {
+                "type": "client_update_delta",
+                "from": <version the server has>,
+                "version": <new version>,
+                "added": [
+                    {
+                        "client-id":"<client-id>",
+                        "public-key":"<public-key>"
+                    },
+                ],
+                "removed": [<client-id>, ]
+            }
 
             websocketpp::connection_hdl hdl - Connection handle of server-server connection
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            outbound_server_server_map - Map of outbound connections
+            connection_table outbound_server_server_map - Map of outbound connections
             ServerList* global_server_list - Pointer to server's ServerList object to generate client update JSON
             int server_id_nosend - Server ID of server to not send client update to
         */
-        void broadcast_client_updates(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, ServerList* global_server_list, int server_id_nosend = 0);
+        void broadcast_client_updates(const connection_table& outbound_server_server_map, ServerList* global_server_list, int server_id_nosend = 0);
         
         /*
             Client list
@@ -204,22 +278,60 @@ class ServerUtilities{
             This is NOT signed and does NOT follow the data format.
 
             server* s - Server instance of client-server connection
-            websocketpp::connection_hdl hdl - Connection handle of client-server connection
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            client_server_map - Map of client-server connections
+            int slot - Slot of the client-server connection in client_server_map
+            connection_table client_server_map - Map of client-server connections
             ServerList* global_server_list - Pointer to server's ServerList object to generate client list JSON
+            message_ptr message - Client list built with make_framed_message(), used instead of global_server_list when broadcasting
         */
-        int send_client_list(server* s, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, ServerList* global_server_list);
+        int send_client_list(server* s, int slot, const connection_table& client_server_map, ServerList* global_server_list);
+        int send_client_list(server* s, int slot, const connection_table& client_server_map, const message_ptr& message);
 
         /*
             Calls send_client_list() function for all clients except the one specified (if provided in call).
+            The list is exported and framed once and the same frame is sent to every client.
 
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            client_server_map - Map of client-server connections
+            connection_table client_server_map - Map of client-server connections
             ServerList* global_server_list - Pointer to server's ServerList object to generate client list JSON
             int client_id_nosend - Client ID of client to not send client list to
+            message_ptr message - Client list built with make_framed_message(), used instead of global_server_list when
+            the same list is sent to several maps
         */
-        void broadcast_client_lists(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, ServerList* global_server_list, int client_id_nosend = 0);
+        void broadcast_client_lists(const connection_table& client_server_map, ServerList* global_server_list, int client_id_nosend = 0);
+        void broadcast_client_lists(const connection_table& client_server_map, const message_ptr& message, int client_id_nosend = 0);
+
+        /*
+            Sends an already built client list to every client that was last sent an older version of the list, and
+            records that they now have it.
+            Clients that asked for deltas are sent only the clients that joined or left since the list they were last sent,
+            each delta is built once for all clients that were sent the same list:
+
+            {
+                "type": "client_list_delta",
+                "from": <version the client has>,
+                "version": <new version>,
+                "added": [
+                    {
+                        "server-id": <server-id>,
+                        "address": "<address>",
+                        "client-id": <client-id>,
+                        "public-key": "<public-key>"
+                    },
+                ],
+                "removed": [
+                    {
+                        "server-id": <server-id>,
+                        "client-id": <client-id>
+                    },
+                ]
+            }
+
+            connection_table client_server_map - Map of client-server connections
+            ServerList* global_server_list - Pointer to server's ServerList object to generate client list deltas
+            message_ptr message - Client list built with make_framed_message()
+            long long directory_version - ServerList version of the client list in message
+            long long version - PresenceScheduler version of the client list in message
+        */
+        void update_client_lists(const connection_table& client_server_map, ServerList* global_server_list, const message_ptr& message, long long directory_version, long long version);
 
         /*
             Public Chat Forwarding to Servers
@@ -227,22 +339,20 @@ class ServerUtilities{
             This function does not formulate any public chat messages, it is only responsible for forwarding them on to another server.
 
             client* c - Client instance of server-server connection
-            websocketpp::connection_hdl hdl - Connection handle of server-server connection
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            outbound_server_server_map - Map of outbound connections
-            std::string message - String form of JSON signed public chat message
+            int slot - Slot of the server-server connection in outbound_server_server_map
+            connection_table outbound_server_server_map - Map of outbound connections
+            message_ptr message - Signed public chat message built with make_message()
         */
-        int send_public_chat_server(client* c, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, std::string message);
+        int send_public_chat_server(client* c, int slot, const connection_table& outbound_server_server_map, const message_ptr& message);
         
         /*
             Calls send_public_chat_server() function for all servers except the one specified.
 
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            outbound_server_server_map - Map of outbound connections
-            std::string message - String form of JSON signed public chat message
+            connection_table outbound_server_server_map - Map of outbound connections
+            std::string message - Received signed public chat message, built once and shared by every connection
             int server_id_nosend - Server ID of server to not send public chat to
         */
-        void broadcast_public_chat_servers(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, std::string message, int server_id_nosend);
+        void broadcast_public_chat_servers(const connection_table& outbound_server_server_map, const std::string& message, int server_id_nosend);
         
         /*
             Public Chat Forwarding to Clients
@@ -250,22 +360,23 @@ class ServerUtilities{
             This function does not formulate any public chat messages, it is only responsible for forwarding them on to another client.
 
             server* s - Server instance of client-server connection
-            websocketpp::connection_hdl hdl - Connection handle of client-server connection
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            client_server_map - Map of client-server connections
-            std::string message - String form of JSON signed public chat message
+            int slot - Slot of the client-server connection in client_server_map
+            connection_table client_server_map - Map of client-server connections
+            message_ptr message - Signed public chat message built with make_framed_message()
         */
-        int send_public_chat_client(server* s, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, std::string message);
+        int send_public_chat_client(server* s, int slot, const connection_table& client_server_map, const message_ptr& message);
         
         /*
             Calls send_public_chat_client() function for all clients except the one specified (if provided in call).
 
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            client_server_map - Map of client-server connections
-            std::string message - String form of JSON signed public chat message
+            connection_table client_server_map - Map of client-server connections
+            std::string message - Received signed public chat message, built once and shared by every connection
             int client_id_nosend - Client ID of client to not send public chat to
+            message_ptr message - Message built with make_framed_message(), used instead of the string when the same
+            chat is sent to several maps
         */
-        void broadcast_public_chat_clients(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, std::string message, int client_id_nosend=0);
+        void broadcast_public_chat_clients(const connection_table& client_server_map, const std::string& message, int client_id_nosend=0);
+        void broadcast_public_chat_clients(const connection_table& client_server_map, const message_ptr& message, int client_id_nosend=0);
 
         /*
             Private Chat Forwarding to Servers
@@ -273,22 +384,20 @@ class ServerUtilities{
             This function does not formulate any private chat messages, it is only responsible for forwarding them on to another server.
 
             client* c - Client instance of server-server connection
-            websocketpp::connection_hdl hdl - Connection handle of server-server connection
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            outbound_server_server_map - Map of outbound connections
-            std::string message - String form of JSON signed private chat message
+            int slot - Slot of the server-server connection in outbound_server_server_map
+            connection_table outbound_server_server_map - Map of outbound connections
+            message_ptr message - Signed private chat message built with make_message()
         */
-        int send_private_chat_server(client* c, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, std::string message);
+        int send_private_chat_server(client* c, int slot, const connection_table& outbound_server_server_map, const message_ptr& message);
         
         /*
-            Calls send_private_chat_server() function for all servers.
+            Calls send_private_chat_server() function for each server in serverSet, finding its connection by address.
 
-            std::unordered_set<std::string> serverSet - Set of servers to forward the private chat to
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            outbound_server_server_map - Map of outbound connections
-            std::string message - String form of JSON signed private chat message
+            std::unordered_set<std::string> serverSet - Set of server addresses to forward the private chat to
+            connection_table outbound_server_server_map - Map of outbound connections
+            std::string message - Received signed private chat message, built once and shared by every connection
         */
-        void broadcast_private_chat_servers(std::unordered_set<std::string> serverSet, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map, std::string message);
+        void broadcast_private_chat_servers(const std::unordered_set<std::string>& serverSet, const connection_table& outbound_server_server_map, const std::string& message);
 
         /*
             Private Chat Forwarding to Clients
@@ -296,38 +405,57 @@ class ServerUtilities{
             This function does not formulate any private chat messages, it is only responsible for forwarding them on to another client.
 
             server* s - Server instance of client-server connection
-            websocketpp::connection_hdl hdl - Connection handle of client-server connection
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            client_server_map - Map of client-server connections
-            std::string message - String form of JSON signed private chat message
+            int slot - Slot of the client-server connection in client_server_map
+            connection_table client_server_map - Map of client-server connections
+            message_ptr message - Signed private chat message built with make_framed_message()
         */
-        int send_private_chat_client(server* s, websocketpp::connection_hdl hdl, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, std::string message);
+        int send_private_chat_client(server* s, int slot, const connection_table& client_server_map, const message_ptr& message);
         
         /*
             Calls send_private_chat_client() function for all clients.
 
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            client_server_map - Map of client-server connections
-            std::string message - String form of JSON signed private chat message
+            connection_table client_server_map - Map of client-server connections
+            std::string message - Received signed private chat message, built once and shared by every connection
             int client_id_nosend - Client ID of client to not send private chat to
+            message_ptr message - Message built with make_framed_message(), used instead of the string when the same
+            chat is sent to several maps
         */
-        void broadcast_private_chat_clients(std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map, std::string message, int client_id_nosend=0);
+        void broadcast_private_chat_clients(const connection_table& client_server_map, const std::string& message, int client_id_nosend=0);
+        void broadcast_private_chat_clients(const connection_table& client_server_map, const message_ptr& message, int client_id_nosend=0);
 
         /*
-            Creates connections to other servers (outbound connections).
-            Responsible for providing data to create and manage outbound connections.
-
-            client* c - Client instance for server-server connection
-            std::string const & uri - URI of server to connect to
-            int server_id - ID of server to connect to
-            EVP_PKEY* private_key - Private key of this server
-            int counter - Current counter value stored on server
+            Calls send_private_chat_client() function for the clients a private chat is addressed to, rather than every client.
+
+            connection_table client_server_map - Map of client-server connections
+            client_fingerprint_table client_fingerprints - Slots of the clients in client_server_map by their fingerprint
+            message_ptr message - Message built with make_framed_message()
+            std::vector<FingerprintDigest> recipients - Fingerprints of the recipients, read by ChatRoute
+            int client_id_nosend - Client ID of client to not send private chat to
+        */
+        void send_private_chat_recipients(const connection_table& client_server_map, const client_fingerprint_table& client_fingerprints, const message_ptr& message, const std::vector<FingerprintDigest>& recipients, int client_id_nosend=0);
+
+        /*
+            Records an outbound (server-server) connection that has opened, giving it a slot in the outbound connection map.
+            Outbound connections are made by OutboundLinks (see outbound_links.h). The outbound map's mutex must be held.
+
+            client* c - Client instance of server-server connection
             websocketpp::connection_hdl hdl - Connection handle of server-server connection
-            std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> 
-            outbound_server_server_map - Pointer to map of outbound connections (need to add created connections to the map)
+            std::string uri - URI of the server
+            int server_id - ID of the server
+            connection_table outbound_server_server_map - Map of outbound connections
+
+            Returns the connection's slot.
+        */
+        int add_outbound(client* c, websocketpp::connection_hdl hdl, const std::string& uri, int server_id, connection_table& outbound_server_server_map);
+
+        // Erases a closed outbound connection from the outbound connection map and frees its slot, the outbound map's mutex must be held
+        void remove_outbound(client* c, websocketpp::connection_hdl hdl, connection_table& outbound_server_server_map);
+
+        /*
+            Returns the slot of the outbound connection to a server in outbound_server_server_map, or -1 if there isn't one.
+            The outbound map's mutex must be held.
         */
-        void connect_to_server(client* c, std::string const & uri, int server_id, EVP_PKEY* private_key, int counter, std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal>* outbound_server_server_map, std::mutex* outbound_map_mutex, int retry_attempts = 0);
-        static std::time_t current_time();
+        int outbound_slot(int server_id);
 };
 
 #endif
\ No newline at end of file
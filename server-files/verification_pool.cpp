@@ -0,0 +1,66 @@
+#include "verification_pool.h"
+
+VerificationPool::VerificationPool(int worker_count, size_t max_queued){
+    maxQueued = max_queued;
+
+    if(worker_count < 1){
+        worker_count = 1;
+    }
+
+    for(int i = 0; i < worker_count; i++){
+        workers.emplace_back([this](){
+            work();
+        });
+    }
+}
+
+VerificationPool::~VerificationPool(){
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        stopping = true;
+    }
+    jobsReady.notify_all();
+
+    for(auto& worker: workers){
+        worker.join();
+    }
+}
+
+void VerificationPool::verify(const std::string& signature, const std::string& data, KeyCache::Handle key, std::function<void(bool)> done){
+    {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        if(jobs.size() < maxQueued){
+            Job job;
+            job.signature = signature;
+            job.data = data;
+            job.key = key;
+            job.done = done;
+            jobs.push_back(std::move(job));
+            jobsReady.notify_one();
+            return;
+        }
+    }
+
+    // Queue is full, verify on this thread
+    done(key && ServerSignature::verifySignature(signature, data, key.get()));
+}
+
+// Verify queued signatures until the pool is stopped
+void VerificationPool::work(){
+    while(true){
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobsMutex);
+            jobsReady.wait(lock, [this](){
+                return stopping || !jobs.empty();
+            });
+            if(jobs.empty()){
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        job.done(job.key && ServerSignature::verifySignature(job.signature, job.data, job.key.get()));
+    }
+}
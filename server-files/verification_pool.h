@@ -0,0 +1,60 @@
+#ifndef verification_pool_h
+#define verification_pool_h
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "server_signature.h"
+#include "../client/key_cache.h"
+
+/*
+    Pool of worker threads that verify message signatures, so RSA verification does not block the server's I/O threads.
+
+    The queue of signatures waiting to be verified is bounded. If it is full the signature is verified on the calling
+    thread instead, which slows down the connections sending the burst rather than letting the queue grow.
+
+    The pool does not order results, callers that need messages handled in order (e.g. per connection) must wait for
+    the result of one message before verifying the next.
+*/
+class VerificationPool{
+    private:
+        struct Job{
+            std::string signature;
+            std::string data;
+            KeyCache::Handle key;
+            std::function<void(bool)> done;
+        };
+
+        std::deque<Job> jobs;
+        size_t maxQueued;
+        bool stopping = false;
+
+        std::mutex jobsMutex;
+        std::condition_variable jobsReady;
+        std::vector<std::thread> workers;
+
+        void work();
+    public:
+        /*
+            int worker_count - Number of worker threads, at least one is always started
+            size_t max_queued - Maximum number of signatures waiting to be verified
+        */
+        VerificationPool(int worker_count, size_t max_queued);
+
+        // Stops the workers once every queued signature has been verified
+        ~VerificationPool();
+
+        /*
+            Verifies a signature over data using key, then calls done with the result.
+            done is called on a worker thread, or on the calling thread if the queue is full.
+            An empty key never verifies.
+        */
+        void verify(const std::string& signature, const std::string& data, KeyCache::Handle key, std::function<void(bool)> done);
+};
+
+#endif
@@ -21,12 +21,23 @@
 #include <functional>
 #include <vector>
 #include <mutex>
+#include <algorithm>
+#include <cstdlib>
 
 //Include server files
 #include "server-files/server_list.h"
 #include "server-files/server_utilities.h"
 #include "server-files/server_key_gen.h"
 #include "server-files/server_signature.h"
+#include "server-files/server_shards.h"
+#include "server-files/verification_pool.h"
+#include "server-files/presence_scheduler.h"
+#include "server-files/outbound_links.h"
+#include "server-files/chat_route.h"
+#include "client/signed_envelope.h"
+#include "client/replay_window.h"
+#include "client/utc_time.h"
+#include "client/logger.h"
 
 // Hard coded server ID + listen port for this server
 const int ServerID = 3; 
@@ -53,148 +64,291 @@ std::unordered_map<int, std::string> server_uris = global_server_list->getUris()
 typedef websocketpp::server<deflate_config> server;
 typedef server::message_ptr message_ptr;
 
-// WebSocket++ client configuration
-typedef websocketpp::client<websocketpp::config::asio_client> client;
+// WebSocket++ client configuration, see server_utilities.h
+typedef websocketpp::client<slot_client_config> client;
 
 
-// Define connection map
-std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> connection_map; 
-std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> client_server_map;
+// Shards owning the connection, client and inbound server maps, created once ASIO is initialised
+ServerShards* server_shards;
 
-// Map for connections made from other servers -> this server
-std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> inbound_server_server_map;
+// Worker threads verifying message signatures off the server threads
+VerificationPool* verification_pool;
 
 // Map for connections made from this server -> other servers
-std::unordered_map<websocketpp::connection_hdl, std::shared_ptr<connection_data>, connection_hdl_hash, connection_hdl_equal> outbound_server_server_map;
+connection_table outbound_server_server_map;
 std::mutex outbound_map_mutex;
 
+// Makes and reconnects the connections to other servers, created once the keys are loaded
+OutboundLinks* neighbour_links;
 
+// Coalesces client list and client update broadcasts, created once ASIO is initialised
+PresenceScheduler* presence_scheduler;
+
+// Send client lists to the clients of every shard that don't have this version yet, the list is exported and framed once
+void broadcast_client_lists(long long version){
+    long long directory_version;
+    message_ptr message = serverUtilities->make_framed_message(global_server_list->exportClientList(-1, directory_version));
+    server_shards->broadcast([message, directory_version, version](server_shard& shard){
+        serverUtilities->update_client_lists(shard.client_server_map, global_server_list, message, directory_version, version);
+    });
+}
+
+// Send a public chat to the clients of every shard
+void broadcast_public_chat_clients(const std::string& payload, int client_id_nosend = 0){
+    message_ptr message = serverUtilities->make_framed_message(payload);
+    server_shards->broadcast([message, client_id_nosend](server_shard& shard){
+        serverUtilities->broadcast_public_chat_clients(shard.client_server_map, message, client_id_nosend);
+    });
+}
+
+// Send a private chat to the clients of every shard
+void broadcast_private_chat_clients(const std::string& payload, int client_id_nosend = 0){
+    message_ptr message = serverUtilities->make_framed_message(payload);
+    server_shards->broadcast([message, client_id_nosend](server_shard& shard){
+        serverUtilities->broadcast_private_chat_clients(shard.client_server_map, message, client_id_nosend);
+    });
+}
+
+// Send a private chat to its recipients among the clients of every shard, or to every client if it doesn't name its recipients
+void deliver_private_chat_clients(const std::string& payload, const std::vector<FingerprintDigest>& recipients, int client_id_nosend = 0){
+    if(recipients.empty()){
+        broadcast_private_chat_clients(payload, client_id_nosend);
+        return;
+    }
+
+    message_ptr message = serverUtilities->make_framed_message(payload);
+    server_shards->broadcast([message, recipients, client_id_nosend](server_shard& shard){
+        serverUtilities->send_private_chat_recipients(shard.client_server_map, shard.client_fingerprints, message, recipients, client_id_nosend);
+    });
+}
+
+// Send client updates to all servers but the one specified (if specified)
+void broadcast_client_updates(int server_id_nosend = 0){
+    std::lock_guard<std::mutex> map_lock(outbound_map_mutex);
+    serverUtilities->broadcast_client_updates(outbound_server_server_map, global_server_list, server_id_nosend);
+}
 
 // Handle incoming connections
-void on_open(server* s, websocketpp::connection_hdl hdl){
-    std::cout << "\nConnection initiated from: " << serverUtilities->getIP(s, hdl) << std::endl;
+void on_open(server* s, server_shard& shard, websocketpp::connection_hdl hdl, connection_slot& connection){
+    LOG_INFO("\nConnection initiated from: " << serverUtilities->getIP(s, hdl));
 
     // Create shared connection_data structure and fill in
     auto con_data = std::make_shared<connection_data>();
     con_data->server_instance = s;
     con_data->connection_hdl = hdl;
 
+    // Give the connection a slot in the shard's maps, later handlers find it from the slot rather than the handle
+    connection.slot = shard.slots.acquire();
+    con_data->slot = connection.slot;
+
     // Create and set timer for connection
     con_data->timer = s->set_timer(10000, [con_data](websocketpp::lib::error_code const &ec){
         if(ec){
             return;
         }
         // If timer runs out, close connection and remove from connection map
-        std::cout << "Timer expired, closing connection." << std::endl;
+        LOG_INFO("Timer expired, closing connection.");
         con_data->server_instance->close(con_data->connection_hdl, websocketpp::close::status::normal, "Hello not received from client.");
     });
     // Place connection_data structure in map
-    connection_map[hdl] = con_data;
+    shard.connection_map[con_data->slot] = con_data;
 }
 
+// Counters seen from each sender, stored against the sender's fingerprint
+ReplayWindow replay_window;
+
 // Handle closing connections
-void on_close(server* s, websocketpp::connection_hdl hdl){
+void on_close(server* s, server_shard& shard, websocketpp::connection_hdl hdl, connection_slot& connection){
+    int slot = connection.slot;
+    if(slot < 0){
+        return;
+    }
+
+    // Drop any messages from this connection that are still waiting to be handled
+    for(auto map: {&shard.connection_map, &shard.client_server_map, &shard.inbound_server_server_map}){
+        auto con_data = map->find(slot);
+        if(con_data != map->end()){
+            con_data->second->closed = true;
+            con_data->second->pending_messages.clear();
+        }
+    }
+
+    // Connection closed before sending a hello
+    shard.connection_map.erase(slot);
+
     // Create iterators to check if the connection being closed is a client or inbound server connection
-    auto it_client = client_server_map.find(hdl);
-    auto it_server = inbound_server_server_map.find(hdl);
+    auto it_client = shard.client_server_map.find(slot);
+    auto it_server = shard.inbound_server_server_map.find(slot);
 
     // If the connection being closed is a client connection
-    if (it_client != client_server_map.end()) {
+    if (it_client != shard.client_server_map.end()) {
         // Client connection
-        std::cout << "\nClient " << client_server_map[hdl]->client_id << " closing their connection" << std::endl;
-        global_server_list->removeClient(client_server_map[hdl]->client_id);
-
-        // Send out client_lists to everyone but the closing connection
-        serverUtilities->broadcast_client_lists(client_server_map, global_server_list, client_server_map[hdl]->client_id);
+        int client_id = it_client->second->client_id;
+        LOG_INFO("\nClient " << client_id << " closing their connection");
+        global_server_list->removeClient(client_id);
+
+        // Stop delivering private chats to the connection, unless the client has since connected again
+        auto fingerprint_slot = shard.client_fingerprints.find(it_client->second->fingerprint);
+        if(fingerprint_slot != shard.client_fingerprints.end() && fingerprint_slot->second == slot){
+            shard.client_fingerprints.erase(fingerprint_slot);
+        }
 
         // Erase from client server map
-        if(client_server_map.find(hdl) != client_server_map.end()){
-            client_server_map.erase(hdl);
-        }
+        shard.client_server_map.erase(it_client);
 
-        serverUtilities->broadcast_client_updates(outbound_server_server_map, global_server_list);
+        // Send out client_lists and client updates once the presence window ends
+        presence_scheduler->markClientLists();
+        presence_scheduler->markClientUpdates();
 
     // If the connection being closed is an inbound server connection
-    } else if (it_server != inbound_server_server_map.end()) {
+    } else if (it_server != shard.inbound_server_server_map.end()) {
         // Server connection
-        std::cout << "\nServer " << inbound_server_server_map[hdl]->server_id << " closing inbound connection" << std::endl;
-        global_server_list->removeServer(inbound_server_server_map[hdl]->server_id);
+        int server_id = it_server->second->server_id;
+        LOG_INFO("\nServer " << server_id << " closing inbound connection");
+        global_server_list->removeServer(server_id);
 
         // Close outbound connection
-        for(const auto& connectPair: outbound_server_server_map){
-            auto connection = connectPair.second;
-            if(connection->server_id == inbound_server_server_map[hdl]->server_id){
-                if(serverUtilities->is_connection_open(connection->client_instance, connection->connection_hdl)){
-                    connection->client_instance->close(connection->connection_hdl, websocketpp::close::status::normal, "Closing both connections");
+        {
+            std::lock_guard<std::mutex> map_lock(outbound_map_mutex);
+            auto outbound = outbound_server_server_map.find(serverUtilities->outbound_slot(server_id));
+            if(outbound != outbound_server_server_map.end()){
+                auto link = outbound->second;
+                if(serverUtilities->is_connection_open(link->client_instance, link->connection_hdl)){
+                    link->client_instance->close(link->connection_hdl, websocketpp::close::status::normal, "Closing both connections");
                 }
             }
         }
 
         // Erase from inbound connection map
-        if(inbound_server_server_map.find(hdl) != inbound_server_server_map.end()){
-            inbound_server_server_map.erase(hdl);
-        }
+        shard.inbound_server_server_map.erase(it_server);
+        server_shards->release_server(server_id);
 
-        // Send out client_lists to all clients
-        serverUtilities->broadcast_client_lists(client_server_map, global_server_list);
+        // Send out client_lists to all clients once the presence window ends
+        presence_scheduler->markClientLists();
     }
+
+    // Messages still being verified for this connection are dropped, so the slot can be given to the next connection
+    shard.slots.release(slot);
+    connection.slot = -1;
 }
 
-// Map to store latest counter for each user
-std::unordered_map <std::string, int> latestCounters;
+// Verify a signature on the verification pool, then continue handling the message on the shard that owns the connection.
+// Other messages from the connection wait until the message has been handled, so they are still handled in order.
+void verify_then(std::shared_ptr<connection_data> con_data, const std::string& signature, const std::string& signed_bytes, KeyCache::Handle key, std::function<void(server_shard&, bool)> next){
+    con_data->verifying = true;
 
-// Handle messages received by server
-int on_message(server* s, websocketpp::connection_hdl hdl, message_ptr msg) {
-    std::cout << "Received message: " << msg->get_payload() << std::endl;
+    verification_pool->verify(signature, signed_bytes, key, [con_data, next](bool verified){
+        server_shards->dispatch(con_data->connection_hdl, [con_data, next, verified](server_shard& shard, connection_slot&){
+            con_data->verifying = false;
 
-    // Vulnerable code: the payload without validation
-    std::string payload = msg->get_payload();
+            // Drop the message if the connection closed while it was being verified
+            if(con_data->closed){
+                con_data->pending_messages.clear();
+                return;
+            }
+            next(shard, verified);
 
-    // Deserialize JSON message
-    nlohmann::json messageJSON;
-    try {
-        // Attempt to parse the string as JSON
-        messageJSON = nlohmann::json::parse(payload);
-        
-    }catch (nlohmann::json::parse_error& e) {
-        // Catch parse error exception and display error message
-        std::cerr << "Invalid JSON format: " << e.what() << std::endl;
+            // Handle messages received while the signature was being verified, until one needs verifying
+            while(!con_data->verifying && !con_data->closed && !con_data->pending_messages.empty()){
+                std::function<void()> pending = con_data->pending_messages.front();
+                con_data->pending_messages.pop_front();
+                pending();
+            }
+        });
+    });
+}
+
+// Handle a private chat from its routing fields once earlier messages from the connection have been handled,
+// the chat is sent on as the payload it was received in
+int handle_chat(server_shard& shard, message_ptr msg, std::shared_ptr<ChatRoute> route, std::shared_ptr<connection_data> con_data) {
+    //parse the TTD timestamp
+    std::time_t ttd_timepoint;
+    if (!UtcTime::parse(route->time_to_die, ttd_timepoint)) {
+        LOG_WARN("Invalid TTD Format, discarding packet.");
+        return -1;
     }
-    std::string dataString;
-    nlohmann::json data;
-
-    if(messageJSON.contains("data")){
-        dataString = messageJSON["data"].get<std::string>();
-        try {
-            // Attempt to parse the string as JSON
-        data = nlohmann::json::parse(dataString);
-            
-        }catch (nlohmann::json::parse_error& e) {
-            // Catch parse error exception and display error message
-            std::cerr << "Invalid JSON format: " << e.what() << std::endl;
-        }
+
+    if (UtcTime::now() >= ttd_timepoint) {
+        LOG_WARN("Message expired based on TTD, discarding packet.");
+        return -1;
     }
 
-    std::shared_ptr<connection_data> con_data;
+    // Declare serverID
+    int server_id;
 
-    // Use handle to check if connection has been confirmed or not
-    if(connection_map.find(hdl) != connection_map.end()){
-        con_data = connection_map[hdl];
-    }else if(inbound_server_server_map.find(hdl) != inbound_server_server_map.end()){
-        con_data = inbound_server_server_map[hdl];
-    }else if(client_server_map.find(hdl) == client_server_map.end()){
-        std::cout << "Connection lost by server" << std::endl;
-        return -1;
+    // If the message came from another server
+    if(shard.inbound_server_server_map.count(con_data->slot)){
+        LOG_DEBUG("Private message has been forwarded.");
+
+        // Send private chats to the recipients connected to this server, or all clients if the chat doesn't name them
+        deliver_private_chat_clients(msg->get_payload(), route->recipients);
+    }else if(shard.client_server_map.count(con_data->slot)){ // If the message came from a client
+        // Assign serverID as this server's ID
+        server_id = ServerID;
+
+        // Obtain client ID
+        int client_id = con_data->client_id;
+
+        // Obtain client's key and fingerprint
+        std::string client_key = global_server_list->retrieveClient(server_id, client_id).second;
+        KeyCache::Handle clientPKey = KeyCache::get(client_key);
+        FingerprintDigest sender = KeyCache::digest(client_key);
+
+        // If no key was found, an unknown fingerprint was sent
+        if(clientPKey == nullptr){
+            LOG_WARN("Error generating fingerprint for sender of private chat message.");
+            return -1;
+        }
+
+        // Verify signature of client sending the message
+        int counter = route->counter;
+        verify_then(con_data, route->signature, route->signedBytes(msg->get_payload()), clientPKey, [msg, route, sender, counter, client_id](server_shard& shard, bool verified){
+            if(!verified){
+                LOG_WARN("Invalid signature for client " << client_id);
+                return;
+            }
+            LOG_DEBUG("Verified signature of client");
+
+            // check the counter has not been seen from this sender, otherwise process the message
+            if (!replay_window.check(sender, counter)) {
+                LOG_WARN("Replay attack detected! Message discarded.");
+                return;
+            }
+
+            // Place destination server addresses in a set
+            std::unordered_set<std::string> serverSet(route->destination_servers.begin(), route->destination_servers.end());
+
+            // If this server is one of the destination servers, it means one of the recipients is a client of this server, so send the
+            // message to the recipients (or every client but the sender if the chat doesn't name them)
+            if(serverSet.find(myAddress) != serverSet.end()){
+                deliver_private_chat_clients(msg->get_payload(), route->recipients, client_id);
+                serverSet.erase(myAddress);
+            }
+
+            // Broadcast the private chat to all required servers
+            std::lock_guard<std::mutex> map_lock(outbound_map_mutex);
+            serverUtilities->broadcast_private_chat_servers(serverSet, outbound_server_server_map, msg->get_payload());
+        });
     }
+    return 0;
+}
+
+// Handle a parsed message once earlier messages from the connection have been handled
+int handle_message(server* s, server_shard& shard, websocketpp::connection_hdl hdl, message_ptr msg, std::shared_ptr<SignedEnvelope> envelope, std::shared_ptr<connection_data> con_data) {
+    // Vulnerable code: the payload without validation
+    const std::string& payload = msg->get_payload();
+
+    nlohmann::json& messageJSON = envelope->message;
+    nlohmann::json& data = envelope->data;
 
     if(data.empty()){
         if(!messageJSON.contains("type")){
-            std::cerr << "Invalid JSON" << std::endl;
+            LOG_WARN("Invalid JSON");
             return 0;
         }
     }else{
         if(!data.contains("type")){
-            std::cerr << "Invalid JSON" << std::endl;
+            LOG_WARN("Invalid JSON");
             return 0;
         }
     }
@@ -203,362 +357,330 @@ int on_message(server* s, websocketpp::connection_hdl hdl, message_ptr msg) {
         if(messageJSON.contains("signature") && messageJSON.contains("counter") && data.contains("public_key")){
 
         }else{
-            std::cerr << "Invalid JSON provided" << std::endl;
+            LOG_WARN("Invalid JSON provided");
             return 0;
         }
         // Cancel connection timer
         con_data->timer->cancel();
-        std::cout << "Cancelling client connection timer" << std::endl;
+        LOG_INFO("Cancelling client connection timer");
 
         // Extract signature and counter
         std::string client_signature = messageJSON["signature"];
         int counter = messageJSON["counter"];
 
-        // Convert public key string to PEM
-        EVP_PKEY* clientPKey = Server_Key_Gen::stringToPEM(data["public_key"]);
+        // Obtain parsed public key and its fingerprint from the key cache
+        KeyCache::Handle clientPKey = KeyCache::get(data["public_key"].get<std::string>());
+        FingerprintDigest fingerprint = KeyCache::digest(data["public_key"].get<std::string>());
 
         // Verify signature and close connection if invalid
-        if(!ServerSignature::verifySignature(client_signature, data.dump() + std::to_string(counter), clientPKey)){
-            std::cout << "Invalid signature for client " << std::endl;
-            s->close(hdl, websocketpp::close::status::policy_violation, "Client signature could not be verified.");
-            if(connection_map.find(hdl) != connection_map.end()){
-                connection_map.erase(hdl);
+        verify_then(con_data, client_signature, envelope->signedBytes(), clientPKey, [s, hdl, envelope, con_data, fingerprint, counter](server_shard& shard, bool verified){
+            if(!verified){
+                LOG_WARN("Invalid signature for client ");
+                s->close(hdl, websocketpp::close::status::policy_violation, "Client signature could not be verified.");
+                shard.connection_map.erase(con_data->slot);
+                return;
             }
-            return -1;
-        }
-
-        // check if the counter is greater than the last known value for this sender
-        if (counter <= latestCounters[client_signature]) {
-            std::cout << "Replay attack detected! Message discarded." << std::endl;
-            return -1;
-        }
-
-        //otherwise, process the message
-        latestCounters[client_signature] = counter;
 
-        // Update client list
-        con_data->client_id = global_server_list->insertClient(data["public_key"]);
-        std::cout << "Verified signature of client " << con_data->client_id << std::endl;
+            // check the counter has not been seen from this sender, otherwise close the connection
+            // Counters are kept across sessions, so a hello captured from an earlier connection is rejected too
+            if (!replay_window.check(fingerprint, counter)) {
+                LOG_WARN("Replay attack detected! Hello discarded.");
+                s->close(hdl, websocketpp::close::status::policy_violation, "Hello counter has already been seen.");
+                shard.connection_map.erase(con_data->slot);
+                return;
+            }
 
-        // Move to client server map
-        client_server_map[hdl] = con_data;
-        if(connection_map.find(hdl) != connection_map.end()){
-            connection_map.erase(hdl);
-        }
+            // Update client list
+            con_data->fingerprint = fingerprint;
+            con_data->client_id = global_server_list->insertClient(envelope->data["public_key"]);
+            LOG_INFO("Verified signature of client " << con_data->client_id);
 
-        // Send out client_lists to all other clients
-        serverUtilities->broadcast_client_lists(client_server_map, global_server_list, con_data->client_id);
+            // Move to client server map
+            shard.client_server_map[con_data->slot] = con_data;
+            shard.client_fingerprints[fingerprint] = con_data->slot;
+            shard.connection_map.erase(con_data->slot);
 
-        serverUtilities->broadcast_client_updates(outbound_server_server_map, global_server_list);
+            // Send out client_lists to all other clients once the presence window ends, the new client requests its own
+            con_data->list_version = presence_scheduler->markClientLists();
+            presence_scheduler->markClientUpdates();
+        });
     }else if(data["type"] == "server_hello"){
-        if(data.contains("sender") && messageJSON.contains("signature") && messageJSON.contains("counter")){
+        if(data.contains("sender") && data["sender"].is_string() && messageJSON.contains("signature") && messageJSON["signature"].is_string() &&
+           messageJSON.contains("counter") && messageJSON["counter"].is_number_integer()){
 
         }else{
-            std::cerr << "Invalid JSON provided" << std::endl;
+            LOG_WARN("Invalid JSON provided");
             return 0;
         }
         // Cancel connection timer
         con_data->timer->cancel();
-        std::cout << "Cancelling server connection timer" << std::endl;
+        LOG_INFO("Cancelling server connection timer");
 
         con_data->server_address = data["sender"];
         //con_data->server_id = data["server_id"];
 
-        // Extract signature and counter to verify signature
+        // Extract signature to verify signature
         std::string server_signature = messageJSON["signature"];
-        int counter = messageJSON["counter"];
 
         con_data->server_id = global_server_list->ObtainID(con_data->server_address);
         if(con_data->server_id == -1){
-            std::cout << "Invalid sender address entered in server hello" << std::endl;
+            LOG_WARN("Invalid sender address entered in server hello");
             return -1;
         }
 
         // Obtain Public server's public key from mapping
-        EVP_PKEY* serverPKey = global_server_list->getPKey(con_data->server_id);
+        KeyCache::Handle serverPKey = global_server_list->getPKey(con_data->server_id);
 
         // Verify signature and close connection if invalid
-        if(!ServerSignature::verifySignature(server_signature, data.dump() + std::to_string(counter), serverPKey)){
-            std::cout << "Invalid signature for server " << con_data->server_id << std::endl;
-            s->close(hdl, websocketpp::close::status::policy_violation, "Server signature could not be verified.");
-            if(connection_map.find(hdl) != connection_map.end()){
-                connection_map.erase(hdl);
+        verify_then(con_data, server_signature, envelope->signedBytes(), serverPKey, [s, hdl, con_data](server_shard& shard, bool verified){
+            if(!verified){
+                LOG_WARN("Invalid signature for server " << con_data->server_id);
+                s->close(hdl, websocketpp::close::status::policy_violation, "Server signature could not be verified.");
+                shard.connection_map.erase(con_data->slot);
+                return;
             }
-            return -1;
-        }
-        std::cout << "Verified signature of server " << con_data->server_id << std::endl;
+            LOG_INFO("Verified signature of server " << con_data->server_id);
 
-        // Check if an existing connection exists
-        for(const auto& connectPair: inbound_server_server_map){
-            auto connection = connectPair.second;
-            if(connection->server_id == con_data->server_id){
+            // Check if an existing connection exists, inbound connections may be owned by any shard
+            if(!server_shards->claim_server(con_data->server_id)){
                 s->close(hdl, websocketpp::close::status::policy_violation, "Connection to this server already exists.");
-                if(connection_map.find(hdl) != connection_map.end()){
-                    connection_map.erase(hdl);
-                }
-                return -1;
+                shard.connection_map.erase(con_data->slot);
+                return;
             }
-        }
 
-        // Add connection data to map
-        inbound_server_server_map[hdl] = con_data;
+            // Add connection data to map
+            shard.inbound_server_server_map[con_data->slot] = con_data;
 
-        // Erase from temporary connection map
-        if(connection_map.find(hdl) != connection_map.end()){
-            connection_map.erase(hdl);
-        }
-        
-        // Check if an outbound connection exists to this server
-        bool outbound_connection_exists = false;
-        for (const auto& pair : outbound_server_server_map) {
-            if (pair.second->server_id == con_data->server_id) {
-                outbound_connection_exists = true;
-                break;
+            // Erase from temporary connection map
+            shard.connection_map.erase(con_data->slot);
+            
+            // Check if an outbound connection exists to this server
+            bool outbound_connection_exists = false;
+            {
+                std::lock_guard<std::mutex> map_lock(outbound_map_mutex);
+                outbound_connection_exists = serverUtilities->outbound_slot(con_data->server_id) >= 0;
             }
-        }
-
-        // If no outbound connection exists, attempt to connect
-        if (!outbound_connection_exists) {
-            std::cout << "No outbound connection to server " << con_data->server_id 
-                    << ". Attempting to establish connection." << std::endl;
-            std::string server_uri = server_uris[con_data->server_id];
-            int serverID = con_data->server_id;
-            if (!server_uri.empty()) {
-                // Start a separate thread to handle the client that connects to ws://localhost:9003
-                std::thread client_thread([server_uri, serverID]() {
-                    std::cout << "Starting client thread..." << "\n" << std::endl;
-
-                    client ws_client;
-
-                    // Set logging settings for the client
-                    ws_client.set_access_channels(websocketpp::log::alevel::none);
-                    ws_client.set_error_channels(websocketpp::log::elevel::none);
-
-                    // Initialize ASIO for the client
-                    ws_client.init_asio();
-
-                    serverUtilities->connect_to_server(&ws_client, server_uri, serverID, privKey, 12345, &outbound_server_server_map, &outbound_map_mutex);
 
-                    ws_client.run();
-
-                });
-                // Detach the client thread so it runs independently
-                client_thread.detach();
-            } else {
-                std::cout << "No URI found for server ID: " << con_data->server_id << std::endl;
+            // If no outbound connection exists, attempt to connect
+            if (!outbound_connection_exists) {
+                LOG_INFO("No outbound connection to server " << con_data->server_id << ". Attempting to establish connection.");
+                auto server_uri = server_uris.find(con_data->server_id);
+                if (server_uri != server_uris.end() && !server_uri->second.empty()) {
+                    // Connect on the outbound links' event loop, a link waiting to retry is retried straight away
+                    neighbour_links->connect(con_data->server_id, server_uri->second);
+                } else {
+                    LOG_WARN("No URI found for server ID: " << con_data->server_id);
+                }
             }
-        }
 
-        // Broadcast client updates to all servers except connecting server
-        serverUtilities->broadcast_client_updates(outbound_server_server_map, global_server_list, con_data->server_id);
+            // Broadcast client updates to all servers once the presence window ends
+            presence_scheduler->markClientUpdates();
+        });
 
     }else if(data["type"] == "public_chat"){
-        if(data.contains("sender") && messageJSON.contains("signature") && messageJSON.contains("counter")){
+        if(data.contains("sender") && data["sender"].is_string() && messageJSON.contains("signature") && messageJSON["signature"].is_string() &&
+           messageJSON.contains("counter") && messageJSON["counter"].is_number_integer()){
 
         }else{
-            std::cerr << "Invalid JSON provided" << std::endl;
+            LOG_WARN("Invalid JSON provided");
             return 0;
         }
-        // Extract signature and counter
+        // Extract signature, counter and sender
         std::string client_signature = messageJSON["signature"];
         int counter = messageJSON["counter"];
+        // Parsed once, the server list and replay window are keyed on the digest rather than the text
+        FingerprintDigest sender = FingerprintDigest::fromText(data["sender"].get<std::string>());
 
         // Declare serverID
         int server_id;
 
         // If the message came from another server
-        if(inbound_server_server_map.find(hdl) != inbound_server_server_map.end()){
-            std::cout << "Message has been forwarded." << std::endl;
+        if(shard.inbound_server_server_map.count(con_data->slot)){
+            LOG_DEBUG("Message has been forwarded.");
 
             // Obtain serverID from connection data retrieved from map
             server_id = con_data->server_id;
 
-            // Obtain client's key
-            EVP_PKEY* clientPKey = Server_Key_Gen::stringToPEM(global_server_list->retrieveClientKey(server_id, data["sender"]));
+            // Obtain client's key, an unknown fingerprint has none
+            std::string senderKey = global_server_list->retrieveClientKey(server_id, sender);
+            KeyCache::Handle clientPKey = senderKey.empty() ? KeyCache::Handle() : KeyCache::get(senderKey);
 
             // If no key was found, an unknown fingerprint was sent
             if(clientPKey == nullptr){
-                std::cout << "Public message contains an unknown fingerprint." << std::endl;
+                LOG_WARN("Public message contains an unknown fingerprint.");
                 return -1;
             }
 
             // Verify signature of sender
-            if(!ServerSignature::verifySignature(client_signature, data.dump() + std::to_string(counter), clientPKey)){
-                std::cout << "Invalid signature" << std::endl;
-                return -1;
-            }
-
-            // check if the counter is greater than the last known value for this sender
-            if (counter <= latestCounters[client_signature]) {
-                std::cout << "Replay attack detected! Message discarded." << std::endl;
-                return -1;
-            }
+            verify_then(con_data, client_signature, envelope->signedBytes(), clientPKey, [msg, sender, counter](server_shard& shard, bool verified){
+                if(!verified){
+                    LOG_WARN("Invalid signature");
+                    return;
+                }
 
-            //otherwise, process the message
-            latestCounters[client_signature] = counter;
+                // check the counter has not been seen from this sender, otherwise process the message
+                if (!replay_window.check(sender, counter)) {
+                    LOG_WARN("Replay attack detected! Message discarded.");
+                    return;
+                }
 
-            // Broadcast public chats to all clients 
-            serverUtilities->broadcast_public_chat_clients(client_server_map, messageJSON.dump());
+                // Broadcast public chats to all clients 
+                broadcast_public_chat_clients(msg->get_payload());
+            });
             return 0;
-        }else if(client_server_map.find(hdl) != client_server_map.end()){ // If the message came from a client
+        }else if(shard.client_server_map.count(con_data->slot)){ // If the message came from a client
             // Assign serverID as this server's ID
             server_id = ServerID;
 
-            // Obtain client's key
-            EVP_PKEY* clientPKey = Server_Key_Gen::stringToPEM(global_server_list->retrieveClientKey(server_id, data["sender"]));
+            // Obtain client's key, an unknown fingerprint has none
+            std::string senderKey = global_server_list->retrieveClientKey(server_id, sender);
+            KeyCache::Handle clientPKey = senderKey.empty() ? KeyCache::Handle() : KeyCache::get(senderKey);
 
             // If no key was found, an unknown fingerprint was sent
             if(clientPKey == nullptr){
-                std::cout << "Public message contains an unknown fingerprint." << std::endl;
+                LOG_WARN("Public message contains an unknown fingerprint.");
                 return -1;
             }
 
             // Obtain client ID
-            int client_id = client_server_map[hdl]->client_id;
+            int client_id = con_data->client_id;
 
             // Verify signature of client sending the message
-            if(!ServerSignature::verifySignature(client_signature, data.dump() + std::to_string(counter), clientPKey)){
-                std::cout << "Invalid signature for client " << client_id << std::endl;
-                return -1;
-            }
-            std::cout << "Verified signature of client" << std::endl;
-
-            // check if the counter is greater than the last known value for this sender
-            if (counter <= latestCounters[client_signature]) {
-                std::cout << "Replay attack detected! Message discarded." << std::endl;
-                return -1;
-            }
-
-            //otherwise, process the message
-            latestCounters[client_signature] = counter;
+            verify_then(con_data, client_signature, envelope->signedBytes(), clientPKey, [msg, sender, counter, client_id, server_id](server_shard& shard, bool verified){
+                if(!verified){
+                    LOG_WARN("Invalid signature for client " << client_id);
+                    return;
+                }
+                LOG_DEBUG("Verified signature of client");
 
-            // Broadcast public chat to all clients except the sender
-            serverUtilities->broadcast_public_chat_clients(client_server_map, messageJSON.dump(), client_id);
-            // Broadcast public chat to all servers except this server
-            serverUtilities->broadcast_public_chat_servers(outbound_server_server_map, messageJSON.dump(), server_id);
+                // check the counter has not been seen from this sender, otherwise process the message
+                if (!replay_window.check(sender, counter)) {
+                    LOG_WARN("Replay attack detected! Message discarded.");
+                    return;
+                }
 
+                // Broadcast public chat to all clients except the sender
+                broadcast_public_chat_clients(msg->get_payload(), client_id);
+                // Broadcast public chat to all servers except this server
+                std::lock_guard<std::mutex> map_lock(outbound_map_mutex);
+                serverUtilities->broadcast_public_chat_servers(outbound_server_server_map, msg->get_payload(), server_id);
+            });
         }
         return 0;
     }else if(data["type"] == "chat"){
-        if(messageJSON.contains("signature") && messageJSON.contains("counter") && data.contains("destination_servers")){
-
-        }else{
-            std::cerr << "Invalid JSON provided" << std::endl;
+        // Chats that couldn't be scanned from their payload are routed from the parsed message
+        std::shared_ptr<ChatRoute> route = std::make_shared<ChatRoute>();
+        if(!route->read(*envelope)){
+            LOG_WARN("Invalid JSON provided");
             return 0;
         }
-        // Extract signature and counter
-        std::string client_signature = messageJSON["signature"];
-        int counter = messageJSON["counter"];
-
-        std::string ttd_timestamp_str = data["time-to-die"];
-
-        //parse the TTD timestamp
-        std::tm ttd_tm = {};
-        std::istringstream ss(ttd_timestamp_str);
-        ss >> std::get_time(&ttd_tm, "%Y-%m-%dT%H:%M:%SZ");
-
-        if (ss.fail()) {
-            std::cout << "Invalid TTD Format";
+        return handle_chat(shard, msg, route, con_data);
+    }else if(messageJSON["type"] == "client_list_request"){
+        // Clients that ask for deltas are sent only what changed after this list
+        if(messageJSON.contains("delta") && messageJSON["delta"].is_boolean()){
+            con_data->delta = messageJSON["delta"];
         }
 
-        auto ttd_timepoint = std::mktime(&ttd_tm);
-
-        auto now = ServerUtilities::current_time();
+        // Send client list to requesting client straight away, this version no longer needs to be broadcast to it
+        con_data->list_version = presence_scheduler->currentVersion();
+        message_ptr clientList = serverUtilities->make_framed_message(global_server_list->exportClientList(-1, con_data->directory_version));
+        serverUtilities->send_client_list(s, con_data->slot, shard.client_server_map, clientList);
+    }else if(messageJSON["type"] == "client_update_request"){
+        // Servers that ask for deltas are sent only what changed after this update
+        bool delta = messageJSON.contains("delta") && messageJSON["delta"].is_boolean() && messageJSON["delta"].get<bool>();
 
-        if (now >= ttd_timepoint) {
-            std::cout << "Message expired based on TTD, discarding packet." << std::endl;
-            return -1;
+        // Find requesting server's outbound connection and send client update on that
+        std::lock_guard<std::mutex> map_lock(outbound_map_mutex);
+        auto outbound = outbound_server_server_map.find(serverUtilities->outbound_slot(con_data->server_id));
+        if(outbound != outbound_server_server_map.end()){
+            auto connection = outbound->second;
+            connection->delta = delta;
+            serverUtilities->send_client_update(connection->client_instance, connection->slot, outbound_server_server_map, global_server_list);
         }
+    }else if(messageJSON["type"] == "client_update"){
+        // Process client update
+        global_server_list->insertServer(con_data->server_id, payload);
 
-        // Declare serverID
-        int server_id;
-
-        // If the message came from another server
-        if(inbound_server_server_map.find(hdl) != inbound_server_server_map.end()){
-            std::cout << "Private message has been forwarded." << std::endl;
-
-            // Broadcast private chats to all clients 
-            serverUtilities->broadcast_private_chat_clients(client_server_map, messageJSON.dump());
-        }else if(client_server_map.find(hdl) != client_server_map.end()){ // If the message came from a client
-            // Assign serverID as this server's ID
-            server_id = ServerID;
-
-            // Obtain client ID
-            int client_id = client_server_map[hdl]->client_id;
-
-            // Obtain client's key
-            EVP_PKEY* clientPKey = Server_Key_Gen::stringToPEM(global_server_list->retrieveClient(server_id, client_id).second);
-
-            // If no key was found, an unknown fingerprint was sent
-            if(clientPKey == nullptr){
-                std::cout << "Error generating fingerprint for sender of private chat message." << std::endl;
-                return -1;
-            }
-
-            // Verify signature of client sending the message
-            if(!ServerSignature::verifySignature(client_signature, data.dump() + std::to_string(counter), clientPKey)){
-                std::cout << "Invalid signature for client " << client_id << std::endl;
-                return -1;
+        // Send out client_lists to all clients once the presence window ends
+        presence_scheduler->markClientLists();
+    }else if(messageJSON["type"] == "client_update_delta"){
+        // Process the clients that joined or left since the server's last update
+        if(!global_server_list->insertServerDelta(con_data->server_id, payload)){
+            // An update was missed, ask for the full client update again
+            LOG_WARN("Client update delta from server " << con_data->server_id << " does not follow last update");
+            std::lock_guard<std::mutex> map_lock(outbound_map_mutex);
+            auto outbound = outbound_server_server_map.find(serverUtilities->outbound_slot(con_data->server_id));
+            if(outbound != outbound_server_server_map.end()){
+                serverUtilities->send_client_update_request(outbound->second->client_instance, outbound->first, outbound_server_server_map);
             }
-            std::cout << "Verified signature of client" << std::endl;
+            return 0;
+        }
+        // Send out client_lists to all clients once the presence window ends
+        presence_scheduler->markClientLists();
+    }
 
-            // check if the counter is greater than the last known value for this sender
-            if (counter <= latestCounters[client_signature]) {
-                std::cout << "Replay attack detected! Message discarded." << std::endl;
-                return -1;
-            }
+    return 0;
+}
 
-            //otherwise, process the message
-            latestCounters[client_signature] = counter;
+// Handle messages received by server
+int on_message(server* s, server_shard& shard, websocketpp::connection_hdl hdl, connection_slot& connection, message_ptr msg) {
+    LOG_PAYLOAD("Received message: " << msg->get_payload());
 
-            // Convert array of destination server addresses to vector of strings
-            std::vector<std::string> destination_servers = data["destination_servers"].get<std::vector<std::string>>();
-            std::unordered_set<std::string> serverSet;
+    std::shared_ptr<connection_data> con_data;
+    
+    // Use the connection's slot to check if connection has been confirmed or not, each check is an array index
+    auto it_connection = shard.connection_map.find(connection.slot);
+    auto it_server = shard.inbound_server_server_map.find(connection.slot);
+    auto it_client = shard.client_server_map.find(connection.slot);
+    if(it_connection != shard.connection_map.end()){
+        con_data = it_connection->second;
+    }else if(it_server != shard.inbound_server_server_map.end()){
+        con_data = it_server->second;
+    }else if(it_client != shard.client_server_map.end()){
+        con_data = it_client->second;
+    }else{
+        LOG_WARN("Connection lost by server");
+        return -1;
+    }
 
-            // Loop through vector and place elements in set
-            for(int i=0; i<(int)destination_servers.size(); i++){
-                serverSet.emplace(destination_servers.at(i));
-            }   
+    // Private chats are routed from the few fields the server needs, the chat itself is never parsed
+    std::shared_ptr<ChatRoute> route = std::make_shared<ChatRoute>();
+    if(route->scan(msg->get_payload())){
+        if(con_data->verifying){
+            server_shard* owner = &shard;
+            con_data->pending_messages.push_back([owner, msg, route, con_data](){
+                handle_chat(*owner, msg, route, con_data);
+            });
+            return 0;
+        }
+        return handle_chat(shard, msg, route, con_data);
+    }
 
-            // If this server is one of the destination servers, it means one of the recipients is a client of this server, so broadcast the
-            // message to every client but the sender
-            if(serverSet.find(myAddress) != serverSet.end()){
-                serverUtilities->broadcast_private_chat_clients(client_server_map, messageJSON.dump(), client_id);
-                serverSet.erase(myAddress);
-            }
+    // Deserialize JSON message and its signed data field, each is only parsed once
+    std::shared_ptr<SignedEnvelope> envelope = std::make_shared<SignedEnvelope>();
+    envelope->parse(msg->get_payload());
 
-            // Broadcast the private chat to all required servers
-            serverUtilities->broadcast_private_chat_servers(serverSet, outbound_server_server_map, messageJSON.dump());
-        }
+    // Wait for the message being verified to be handled first, a client list request only waits for the client's hello
+    if(con_data->waits_for_verification(envelope->message, it_client != shard.client_server_map.end())){
+        server_shard* owner = &shard;
+        con_data->pending_messages.push_back([s, owner, hdl, msg, envelope, con_data](){
+            handle_message(s, *owner, hdl, msg, envelope, con_data);
+        });
         return 0;
-    }else if(messageJSON["type"] == "client_list_request"){
-        // Send client list to requesting client
-        serverUtilities->send_client_list(s, hdl, client_server_map, global_server_list);
-    }else if(messageJSON["type"] == "client_update_request"){
-        // Find requesting server's outbound connection and send client update on that
-        for(const auto& connectPair: outbound_server_server_map){
-            auto connection = connectPair.second;
-            
-            if(connection->server_id == con_data->server_id){
-                serverUtilities->send_client_update(connection->client_instance, connection->connection_hdl, outbound_server_server_map, global_server_list);
-            }
-        }
-    }else if(messageJSON["type"] == "client_update"){
-        // Process client update
-        global_server_list->insertServer(con_data->server_id, payload);
-
-        // Send out client_lists to all clients
-        serverUtilities->broadcast_client_lists(client_server_map, global_server_list);
     }
 
-    std::cout << "\n";
-
-    return 0;
+    return handle_message(s, shard, hdl, msg, envelope, con_data);
 }
 
 
 
 int main(int argc, char * argv[]) {
+    // Write log lines on their own thread
+    LogWriter log_writer;
+
+    // Keep the time used for time-to-die checks up to date
+    UtcClock utc_clock;
+
     // Load keys
     privKey = Server_Key_Gen::loadPrivateKey(privFileName.c_str());
     pubKey = Server_Key_Gen::loadPublicKey(pubFileName.c_str());
@@ -566,23 +688,59 @@ int main(int argc, char * argv[]) {
     // If keys files don't exist, create keys and load from newly created files
     if(!privKey || !pubKey){
         if(!Server_Key_Gen::key_gen(ServerID)){
-            std::cout << "\nCreating key files\n" << std::endl;
+            LOG_INFO("\nCreating key files\n");
             privKey = Server_Key_Gen::loadPrivateKey(privFileName.c_str());
             pubKey = Server_Key_Gen::loadPublicKey(pubFileName.c_str());
         }else{
-            std::cout << "Could not load keys" << std::endl;
+            LOG_ERROR("Could not load keys");
             return 1;
         }
     }
 
-    // Create a WebSocket++ client instance
-    client ws_client;
-
     server ws_server;
 
+    // Number of threads running the server, and shards its connections are split across
+    int threadCount = 1;
+    // Number of threads verifying signatures
+    int verifierCount = std::max(1, (int)std::thread::hardware_concurrency());
+    // Minimum time between client list and client update broadcasts in milliseconds
+    int presenceWindow = 50;
+    // Seconds between logging the state of the links to other servers, 0 to never log it
+    int statusInterval = 0;
+    bool debug = false;
+
+    // -d enables debug logging, -l logs every message received, -t <threads> runs the server on a pool of threads, -v <threads> sets the number of signature verification threads,
+    // -p <ms> sets the presence broadcast window, -j keeps the JSON mapping file up to date alongside the binary snapshot,
+    // -k <clients> sets the number of known clients kept in the mapping, -s <seconds> logs the state of the links to other servers every interval
+    for(int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if(arg == "-d"){
+            debug = true;
+            Logger::setLevel(Logger::Debug);
+        }else if(arg == "-l"){
+            Logger::setPayloads(true);
+        }else if(arg == "-t" && i + 1 < argc){
+            threadCount = std::max(1, std::atoi(argv[++i]));
+        }else if(arg == "-v" && i + 1 < argc){
+            verifierCount = std::max(1, std::atoi(argv[++i]));
+        }else if(arg == "-p" && i + 1 < argc){
+            presenceWindow = std::max(0, std::atoi(argv[++i]));
+        }else if(arg == "-j"){
+            global_server_list->exportMappingJson(true);
+        }else if(arg == "-k" && i + 1 < argc){
+            global_server_list->setKnownClientCapacity(std::max(1, std::atoi(argv[++i])));
+            LOG_INFO("Keeping up to " << argv[i] << " known clients, " << global_server_list->evictedClientCount() << " evicted");
+        }else if(arg == "-s" && i + 1 < argc){
+            statusInterval = std::max(0, std::atoi(argv[++i]));
+        }
+    }
+
+    // Signatures waiting beyond this are verified on the server threads instead
+    verification_pool = new VerificationPool(verifierCount, 1024);
+
     try {
         // Set logging settings        
-        if (argc > 1 && std::string(argv[1]) == "-d") {
+        if (debug) {
             ws_server.set_access_channels(websocketpp::log::alevel::all);
             ws_server.set_error_channels(websocketpp::log::elevel::all);
             
@@ -594,36 +752,41 @@ int main(int argc, char * argv[]) {
         // Initialize ASIO
         ws_server.init_asio();
 
-        // Set handlers
-        ws_server.set_open_handler(bind(&on_open, &ws_server, std::placeholders::_1));
-        ws_server.set_close_handler(bind(&on_close, &ws_server, std::placeholders::_1));
-        ws_server.set_message_handler(bind(&on_message, &ws_server, std::placeholders::_1, std::placeholders::_2));
-
-        // Start a separate thread to handle the clients that connect to other servers
-        std::thread client_thread([]() {
-            std::cout << "Starting client thread..." << "\n" << std::endl;
-
-            client ws_client;
-
-            // Set logging settings for the client
-            ws_client.set_access_channels(websocketpp::log::alevel::none);
-            ws_client.set_error_channels(websocketpp::log::elevel::none);
-
-            // Initialize ASIO for the client
-            ws_client.init_asio();
+        // Split connections across one shard per thread
+        server_shards = new ServerShards(&ws_server, threadCount);
 
-            // Loop through the server URIs and attempt connections
-            for(const auto& uri: server_uris){
-                serverUtilities->connect_to_server(&ws_client, uri.second, uri.first, privKey, 12345, &outbound_server_server_map, &outbound_map_mutex);
-                
-            }
+        // Send client lists and client updates at most once per presence window
+        presence_scheduler = new PresenceScheduler(&ws_server, presenceWindow, broadcast_client_lists, [](){
+            broadcast_client_updates();
+        });
 
-            // Start the client io_service run loop
-            ws_client.run();
+        // Set handlers, each handler runs on the shard that owns the connection
+        ws_server.set_open_handler([&ws_server](websocketpp::connection_hdl hdl){
+            server_shards->dispatch(hdl, [&ws_server, hdl](server_shard& shard, connection_slot& connection){
+                on_open(&ws_server, shard, hdl, connection);
+            });
+        });
+        ws_server.set_close_handler([&ws_server](websocketpp::connection_hdl hdl){
+            server_shards->dispatch(hdl, [&ws_server, hdl](server_shard& shard, connection_slot& connection){
+                on_close(&ws_server, shard, hdl, connection);
+            });
+        });
+        ws_server.set_message_handler([&ws_server](websocketpp::connection_hdl hdl, message_ptr msg){
+            server_shards->dispatch(hdl, [&ws_server, hdl, msg](server_shard& shard, connection_slot& connection){
+                on_message(&ws_server, shard, hdl, connection, msg);
+            });
         });
 
-        // Detach the client thread so it runs independently
-        client_thread.detach();
+        // Connect to the other servers, every outbound connection runs on the outbound links' single event loop thread
+        LOG_INFO("Starting client thread...");
+        neighbour_links = new OutboundLinks(serverUtilities, privKey, 12345, &outbound_server_server_map, &outbound_map_mutex);
+        neighbour_links->start();
+        for(const auto& uri: server_uris){
+            neighbour_links->connect(uri.first, uri.second);
+        }
+        if(statusInterval > 0){
+            neighbour_links->reportStatus(statusInterval * 1000);
+        }
         
         // Listen on port 9002
         ws_server.listen(listenPort);
@@ -631,19 +794,20 @@ int main(int argc, char * argv[]) {
         // Start the server accept loop
         ws_server.start_accept();
 
-        // Start the ASIO io_service run loop
-        ws_server.run();
+        // Start the ASIO io_service run loop on every thread
+        LOG_INFO("Running server on " << threadCount << " thread(s)");
+        server_shards->run(threadCount);
 
     } catch (const websocketpp::exception & e) {
-        std::cout << "WebSocket++ exception: " << e.what() << std::endl;
+        LOG_ERROR("WebSocket++ exception: " << e.what());
         EVP_PKEY_free(privKey);
         EVP_PKEY_free(pubKey);
     } catch (const std::exception & e) {
-        std::cout << "Standard exception: " << e.what() << std::endl;
+        LOG_ERROR("Standard exception: " << e.what());
         EVP_PKEY_free(privKey);
         EVP_PKEY_free(pubKey);
     } catch (...) {
-        std::cout << "Unknown exception" << std::endl;
+        LOG_ERROR("Unknown exception");
         EVP_PKEY_free(privKey);
         EVP_PKEY_free(pubKey);
     }
@@ -0,0 +1,94 @@
+#include "../client/flat_map.h"
+#include <unordered_map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+// Counts bytes currently allocated so the memory each map uses per entry can be reported
+static size_t allocated = 0;
+
+void* operator new(size_t size){
+    void* memory = std::malloc(size);
+    if(!memory){
+        throw std::bad_alloc();
+    }
+    allocated += malloc_usable_size(memory);
+    return memory;
+}
+void operator delete(void* memory) noexcept {
+    if(memory){
+        allocated -= malloc_usable_size(memory);
+    }
+    std::free(memory);
+}
+
+typedef std::shared_ptr<const std::string> Key;
+
+template<typename Clock>
+static double elapsed(typename Clock::time_point start){
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Times building a directory of clients, looking every client up in a random order, and exporting the directory
+template<typename Map>
+static void run(const char* name, size_t clients, const Key& key, const std::vector<int>& lookups){
+    typedef std::chrono::steady_clock Clock;
+
+    size_t before = allocated;
+    Clock::time_point start = Clock::now();
+    Map map;
+    for(size_t i = 0; i < clients; i++){
+        map[1000 + (int)i] = key;
+    }
+    double insertTime = elapsed<Clock>(start);
+    size_t bytes = allocated - before;
+
+    start = Clock::now();
+    size_t found = 0;
+    for(int id: lookups){
+        if(map.find(id) != map.end()){
+            found++;
+        }
+    }
+    double lookupTime = elapsed<Clock>(start);
+
+    start = Clock::now();
+    size_t exported = 0;
+    for(const auto& client: map){
+        exported += client.first + client.second->size();
+    }
+    double exportTime = elapsed<Clock>(start);
+
+    std::cout << std::setw(14) << name << std::setw(10) << clients
+              << std::setw(12) << std::fixed << std::setprecision(1) << (double)bytes / clients
+              << std::setw(12) << std::setprecision(2) << insertTime
+              << std::setw(12) << lookupTime
+              << std::setw(12) << exportTime
+              << (found == lookups.size() && exported > 0 ? "" : "  (check failed)") << std::endl;
+}
+
+int main(){
+    Key key = std::make_shared<const std::string>(450, 'k');
+
+    std::cout << std::setw(14) << "map" << std::setw(10) << "clients" << std::setw(12) << "bytes/entry"
+              << std::setw(12) << "insert ms" << std::setw(12) << "lookup ms" << std::setw(12) << "export ms" << std::endl;
+
+    for(size_t clients: {10000, 100000, 1000000}){
+        std::mt19937 rng(1);
+        std::vector<int> lookups(clients);
+        for(auto& id: lookups){
+            id = 1000 + (int)(rng() % clients);
+        }
+
+        run<std::unordered_map<int, Key>>("unordered_map", clients, key, lookups);
+        run<FlatMap<int, Key>>("FlatMap", clients, key, lookups);
+    }
+    return 0;
+}
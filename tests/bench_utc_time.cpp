@@ -0,0 +1,86 @@
+#include "../client/utc_time.h"
+#include <string>
+#include <vector>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+// The time-to-die handling UtcTime replaces: stream formatting, std::get_time parsing and std::mktime
+static std::string streamFormat(std::time_t time){
+    std::tm* utc_tm = std::gmtime(&time);
+    std::stringstream timeString;
+    timeString << std::put_time(utc_tm, "%Y-%m-%dT%H:%M:%SZ");
+    return timeString.str();
+}
+
+static std::time_t streamParse(const std::string& timestamp){
+    std::tm ttd_tm = {};
+    std::istringstream ss(timestamp);
+    ss >> std::get_time(&ttd_tm, "%Y-%m-%dT%H:%M:%SZ");
+    return std::mktime(&ttd_tm);
+}
+
+static std::time_t gmtimeNow(){
+    std::time_t convTime = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm* utc_tm = std::gmtime(&convTime);
+    return std::mktime(utc_tm);
+}
+
+template<typename Clock>
+static double elapsed(typename Clock::time_point start, size_t count){
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+}
+
+// Times formatting, parsing and reading the current time, reported in nanoseconds per call
+int main(){
+    typedef std::chrono::steady_clock Clock;
+    const size_t count = 1000000;
+
+    std::vector<std::string> timestamps;
+    for(size_t i = 0; i < 1000; i++){
+        timestamps.push_back(UtcTime::format(1700000000 + (std::time_t)i * 7919));
+    }
+
+    long long check = 0;
+    std::cout << std::setw(10) << "" << std::setw(14) << "format ns" << std::setw(14) << "parse ns" << std::setw(14) << "now ns" << std::endl;
+
+    Clock::time_point start = Clock::now();
+    for(size_t i = 0; i < count; i++){
+        check += streamFormat(1700000000 + (std::time_t)i).size();
+    }
+    double formatTime = elapsed<Clock>(start, count);
+    start = Clock::now();
+    for(size_t i = 0; i < count; i++){
+        check += streamParse(timestamps[i % timestamps.size()]);
+    }
+    double parseTime = elapsed<Clock>(start, count);
+    start = Clock::now();
+    for(size_t i = 0; i < count; i++){
+        check += gmtimeNow();
+    }
+    double nowTime = elapsed<Clock>(start, count);
+    std::cout << std::setw(10) << "stream" << std::fixed << std::setprecision(1) << std::setw(14) << formatTime << std::setw(14) << parseTime << std::setw(14) << nowTime << std::endl;
+
+    UtcClock clock;
+    start = Clock::now();
+    for(size_t i = 0; i < count; i++){
+        check += UtcTime::format(1700000000 + (std::time_t)i).size();
+    }
+    formatTime = elapsed<Clock>(start, count);
+    start = Clock::now();
+    for(size_t i = 0; i < count; i++){
+        std::time_t time = 0;
+        UtcTime::parse(timestamps[i % timestamps.size()], time);
+        check += time;
+    }
+    parseTime = elapsed<Clock>(start, count);
+    start = Clock::now();
+    for(size_t i = 0; i < count; i++){
+        check += UtcTime::now();
+    }
+    nowTime = elapsed<Clock>(start, count);
+    std::cout << std::setw(10) << "UtcTime" << std::setw(14) << formatTime << std::setw(14) << parseTime << std::setw(14) << nowTime << std::endl;
+
+    return check == 0;
+}
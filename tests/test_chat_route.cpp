@@ -0,0 +1,230 @@
+#include "../server-files/chat_route.h"
+#include "../client/signed_envelope.h"
+#include "../client/fingerprint_digest.h"
+#include "../client/Sha256Hash.h"
+#include <iostream>
+
+// Builds a signed_data payload the way a client does, with the data field held as a JSON string
+std::string signedPayload(const nlohmann::json& data, int counter){
+    nlohmann::json message;
+    message["type"] = "signed_data";
+    message["data"] = data.dump();
+    message["counter"] = counter;
+    message["signature"] = "c2lnbmF0dXJl";
+    return message.dump();
+}
+
+nlohmann::json chatData(const std::vector<std::string>& recipients){
+    nlohmann::json data;
+    data["type"] = "chat";
+    data["destination_servers"] = {"127.0.0.1:9002", "127.0.0.1:9003"};
+    data["time-to-die"] = "2024-10-17T09:30:00Z";
+    data["iv"] = "aXY=";
+    data["symm_keys"] = {"a2V5MQ==", "a2V5Mg=="};
+    data["chat"] = "Y2hhdA==";
+    if(!recipients.empty()){
+        data["recipients"] = recipients;
+    }
+    return data;
+}
+
+// Builds a signed_data payload with a field whose value is written as given into the data string, valid JSON or not
+std::string withDataField(const std::string& value){
+    std::string data = chatData({}).dump();
+    data.insert(1, "\"extra\":" + value + ",");
+    nlohmann::json message = nlohmann::json::parse(signedPayload(nlohmann::json::object(), 7));
+    message["data"] = data;
+    return message.dump();
+}
+
+// The scanner must never accept a payload the full parser rejects, the chat then falls back to being parsed in full
+bool fullyParsed(const std::string& payload){
+    SignedEnvelope envelope;
+    return envelope.parse(payload) && envelope.data.is_object();
+}
+
+int main(){
+    std::string alice = FingerprintDigest::fromHex(Sha256Hash::hashStringSha256("alice")).toText();
+    std::string bob = FingerprintDigest::fromHex(Sha256Hash::hashStringSha256("bob")).toText();
+
+    // Routing fields are read without parsing the chat
+    std::string payload = signedPayload(chatData({alice, bob}), 7);
+    ChatRoute route;
+    if (!route.scan(payload)) {
+        std::cerr << "Chat could not be scanned!" << std::endl;
+        return -1;
+    }
+    if (route.counter != 7 || route.signature != "c2lnbmF0dXJl" || route.time_to_die != "2024-10-17T09:30:00Z") {
+        std::cerr << "Signature, counter or time-to-die read incorrectly!" << std::endl;
+        return -1;
+    }
+    if (route.destination_servers != std::vector<std::string>({"127.0.0.1:9002", "127.0.0.1:9003"})) {
+        std::cerr << "Destination servers read incorrectly!" << std::endl;
+        return -1;
+    }
+    if (route.recipients.size() != 2 || route.recipients[0] != FingerprintDigest::fromText(alice) || route.recipients[1] != FingerprintDigest::fromText(bob)) {
+        std::cerr << "Recipients read incorrectly!" << std::endl;
+        return -1;
+    }
+
+    // An invalid recipient means the chat is sent to every client
+    ChatRoute invalidRecipient;
+    if (!invalidRecipient.scan(signedPayload(chatData({alice, "not a fingerprint"}), 7)) || !invalidRecipient.recipients.empty()) {
+        std::cerr << "Invalid recipient was kept!" << std::endl;
+        return -1;
+    }
+    std::cout << "Routing fields read" << std::endl;
+
+    // The signed bytes are the data string exactly as it was sent, escapes undone
+    nlohmann::json escaped = chatData({alice});
+    escaped["chat"] = "quote \" backslash \\ slash / newline \n tab \t";
+    payload = signedPayload(escaped, 8);
+    std::string slashed = payload;
+    slashed.replace(slashed.find("slash /"), 7, "slash \\\\/");
+    for (const std::string& sent: {payload, slashed}) {
+        SignedEnvelope envelope;
+        envelope.parse(sent);
+        ChatRoute escapedRoute;
+        if (!escapedRoute.scan(sent) || escapedRoute.signedBytes(sent) != envelope.signedBytes()) {
+            std::cerr << "Signed bytes differ from the parsed message!" << std::endl;
+            return -1;
+        }
+    }
+    std::cout << "Signed bytes match the parsed message" << std::endl;
+
+    // \u escapes are left to the full parser, read() gives the same fields and signed bytes
+    nlohmann::json unicode = chatData({alice});
+    unicode["chat"] = std::string("control \x01 character");
+    payload = signedPayload(unicode, 9);
+    ChatRoute unicodeRoute;
+    if (payload.find("\\\\u0001") == std::string::npos || unicodeRoute.scan(payload)) {
+        std::cerr << "Payload with a \\u escape was scanned!" << std::endl;
+        return -1;
+    }
+    SignedEnvelope unicodeEnvelope;
+    unicodeEnvelope.parse(payload);
+    ChatRoute readRoute;
+    if (!readRoute.read(unicodeEnvelope) || readRoute.counter != 9 || readRoute.recipients.size() != 1 || readRoute.destination_servers.size() != 2 ||
+        readRoute.signedBytes(payload) != unicodeEnvelope.signedBytes()) {
+        std::cerr << "Parsed chat was read incorrectly!" << std::endl;
+        return -1;
+    }
+    std::cout << "Payload with a \\u escape left to the full parser" << std::endl;
+
+    // Fields in any order, and the last of a repeated field counts, as when parsed in full
+    std::string data = "{\\\"time-to-die\\\":\\\"2024-01-01T00:00:00Z\\\",\\\"recipients\\\":[\\\"" + bob + "\\\"],\\\"chat\\\":{\\\"nested\\\":[1,{\\\"a\\\":\\\"]}\\\"}]},"
+                       "\\\"destination_servers\\\":[\\\"a\\\"],\\\"type\\\":\\\"chat\\\",\\\"destination_servers\\\":[\\\"b\\\",\\\"c\\\"],"
+                       "\\\"time-to-die\\\":\\\"2024-10-17T09:30:00Z\\\",\\\"recipients\\\":[\\\"" + alice + "\\\"]}";
+    payload = "{ \"counter\" : 3, \"signature\":\"first\", \"data\" : \"" + data + "\", \"counter\": 11, \"signature\":\"second\", \"type\":\"signed_data\" }";
+    SignedEnvelope reordered;
+    if (!reordered.parse(payload)) {
+        std::cerr << "Reordered payload is not valid JSON!" << std::endl;
+        return -1;
+    }
+    ChatRoute reorderedRoute;
+    if (!reorderedRoute.scan(payload)) {
+        std::cerr << "Reordered payload could not be scanned!" << std::endl;
+        return -1;
+    }
+    if (reorderedRoute.counter != reordered.counter() || reorderedRoute.signature != reordered.signature() ||
+        reorderedRoute.time_to_die != reordered.data["time-to-die"] || reorderedRoute.destination_servers != reordered.data["destination_servers"].get<std::vector<std::string>>() ||
+        reorderedRoute.recipients.size() != 1 || reorderedRoute.recipients[0] != FingerprintDigest::fromText(alice) ||
+        reorderedRoute.signedBytes(payload) != reordered.signedBytes()) {
+        std::cerr << "Repeated or reordered fields read differently to the full parser!" << std::endl;
+        return -1;
+    }
+    std::cout << "Reordered and repeated fields read as the full parser reads them" << std::endl;
+
+    // Truncated payloads are never scanned
+    payload = signedPayload(chatData({alice, bob}), 7);
+    for (size_t length = 0; length < payload.size(); length++) {
+        ChatRoute truncated;
+        if (truncated.scan(payload.substr(0, length))) {
+            std::cerr << "Payload truncated to " << length << " characters was scanned!" << std::endl;
+            return -1;
+        }
+    }
+    ChatRoute unterminated;
+    std::string open = payload;
+    open.erase(open.rfind("\",\"signature\""), 1);
+    if (unterminated.scan(open) || unterminated.scan("{\"data\":\"{\\\"type\\\":\\\"chat")) {
+        std::cerr << "Unterminated data string was scanned!" << std::endl;
+        return -1;
+    }
+    std::cout << "Truncated payloads rejected" << std::endl;
+
+    // Only whitespace may follow the top-level object
+    payload = signedPayload(chatData({alice, bob}), 7);
+    for (const std::string& trailing: {std::string("x"), std::string("}"), std::string(" {}"), std::string(",")}) {
+        ChatRoute trailed;
+        if (trailed.scan(payload + trailing) || fullyParsed(payload + trailing)) {
+            std::cerr << "Payload followed by " << trailing << " was scanned!" << std::endl;
+            return -1;
+        }
+    }
+    ChatRoute spaced;
+    if (!spaced.scan(" " + payload + " \r\n\t") || spaced.counter != 7) {
+        std::cerr << "Payload surrounded by whitespace could not be scanned!" << std::endl;
+        return -1;
+    }
+    std::cout << "Trailing data rejected" << std::endl;
+
+    // Skipped values are validated, bad literals, numbers and nesting are rejected as the full parser rejects them
+    for (const char* invalid: {"tru", "nul", "True", "foo", "01", "-01", "1.", "-", "1e", "1e+", ".5", "+1", "0x10", "[1 2]", "[1,]", "[}", "{\"a\"}",
+                                      "{\"a\":1,}", "{1:2}", "{\"a\" 1}", "\"tab\t\"", "[[]"}) {
+        ChatRoute invalidRoute;
+        if (invalidRoute.scan(withDataField(invalid)) || fullyParsed(withDataField(invalid))) {
+            std::cerr << "Data with an invalid value " << invalid << " was scanned!" << std::endl;
+            return -1;
+        }
+    }
+    nlohmann::json badOuter = nlohmann::json::parse(signedPayload(chatData({alice}), 7));
+    badOuter.erase("type");
+    payload = badOuter.dump();
+    std::string outerLiteral = payload;
+    outerLiteral.insert(1, "\"type\":\"signed_data\",\"extra\":yes,");
+    std::string leadingZero = signedPayload(chatData({alice}), 7);
+    leadingZero.replace(leadingZero.find("\"counter\":7"), 11, "\"counter\":007");
+    for (const std::string& invalid: {payload, outerLiteral, leadingZero}) {
+        ChatRoute invalidRoute;
+        if (invalidRoute.scan(invalid)) {
+            std::cerr << "Payload with an invalid or missing outer field was scanned: " << invalid << std::endl;
+            return -1;
+        }
+    }
+    for (const char* valid: {"true", "false", "null", "0", "-1.5e+3", "2E-7", "[]", "{}", "[1, {\"a\": [null, false]}, \"]\"]", " { \"a\" : { } } "}) {
+        ChatRoute validRoute;
+        if (!validRoute.scan(withDataField(valid)) || !fullyParsed(withDataField(valid))) {
+            std::cerr << "Data with a valid value " << valid << " could not be scanned!" << std::endl;
+            return -1;
+        }
+    }
+    std::string deep = std::string(100000, '[') + std::string(100000, ']');
+    ChatRoute deepRoute;
+    if (!deepRoute.scan(withDataField(deep)) || deepRoute.scan(withDataField(deep.substr(1)))) {
+        std::cerr << "Deeply nested value scanned incorrectly!" << std::endl;
+        return -1;
+    }
+    std::cout << "Invalid values rejected, valid values scanned" << std::endl;
+
+    // Other messages are left to the full parser
+    nlohmann::json publicChat = {{"type", "public_chat"}, {"sender", alice}, {"message", "Hello"}};
+    nlohmann::json hello = {{"type", "hello"}, {"public_key", "key"}};
+    nlohmann::json notSigned = nlohmann::json::parse(signedPayload(chatData({alice}), 7));
+    notSigned["type"] = "unsigned";
+    nlohmann::json noCounter = nlohmann::json::parse(signedPayload(chatData({alice}), 7));
+    noCounter.erase("counter");
+    nlohmann::json noTTD = chatData({alice});
+    noTTD.erase("time-to-die");
+    for (const std::string& other: {signedPayload(publicChat, 7), signedPayload(hello, 7), notSigned.dump(), noCounter.dump(), signedPayload(noTTD, 7),
+                                    std::string("{\"type\":\"client_list_request\"}")}) {
+        ChatRoute otherRoute;
+        if (otherRoute.scan(other)) {
+            std::cerr << "Message that isn't a signed chat was scanned: " << other << std::endl;
+            return -1;
+        }
+    }
+    std::cout << "Messages that aren't signed chats rejected" << std::endl;
+
+    return 0;
+}
@@ -72,5 +72,44 @@ int main() {
         std::cerr << "Error: " << e.what() << std::endl;
     }
 
+    // A list without a version can't have deltas applied to it
+    nlohmann::json delta = {
+        {"type", "client_list_delta"},
+        {"from", 4},
+        {"version", 5},
+        {"added", nlohmann::json::array()},
+        {"removed", {{{"server-id", 1}, {"client-id", 1002}}}}
+    };
+    if (client_list.applyDelta(delta)) {
+        std::cerr << "Delta applied to a list without a version!" << std::endl;
+        return -1;
+    }
+
+    // Deltas apply on top of the version of the full list
+    data["version"] = 4;
+    client_list.update(data);
+    std::string movedKey = client_list.retrieveClient(1, 1002).second;
+    delta["added"] = {{{"server-id", 3}, {"address", "192.168.1.3"}, {"client-id", 3001}, {"public-key", movedKey}}};
+    if (!client_list.applyDelta(delta)) {
+        std::cerr << "Delta was not applied!" << std::endl;
+        return -1;
+    }
+    if (client_list.retrieveClient(1, 1002).second != "" || client_list.retrieveClient(3, 3001).second != movedKey || client_list.retrieveAddress(3) != "192.168.1.3") {
+        std::cerr << "Delta was applied incorrectly!" << std::endl;
+        return -1;
+    }
+    if (client_list.retrieveClientFromFingerprint(KeyCache::fingerprint(movedKey)).first != 3) {
+        std::cerr << "Fingerprint was not moved to the new client!" << std::endl;
+        return -1;
+    }
+    std::cout << "Client list delta applied" << std::endl;
+
+    // A delta that doesn't follow the current version is rejected
+    if (client_list.applyDelta(delta)) {
+        std::cerr << "Out of order delta was applied!" << std::endl;
+        return -1;
+    }
+    std::cout << "Out of order client list delta rejected" << std::endl;
+
     return 0;
 }
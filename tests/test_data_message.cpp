@@ -2,6 +2,7 @@
 #include "../client/client_key_gen.h"
 #include "../client/hexToBytes.h"
 #include "../client/client_utilities.h"
+#include "../client/signed_data.h"
 #include <iostream>
 
 int numRecipients=2;
@@ -69,6 +70,19 @@ int main(){
     // Remove tag from cipher text string to leave actual ciphertext
     ciphertextString = ciphertextString.substr(0, ciphertextString.length() - AES_GCM_TAG_SIZE);
 
+    // Each symmetric key is named by the ID of the key it was encrypted with
+    if(!dataJSON.contains("symm_key_ids") || dataJSON["symm_key_ids"].size() != (size_t)numRecipients){
+        std::cerr << "Key IDs missing!" << std::endl;
+        return 1;
+    }
+    for(int i=0; i<numRecipients; i++){
+        if(dataJSON["symm_key_ids"][i] != DataMessage::keyId(private_keys[i])){
+            std::cerr << "Key ID does not match recipient!" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Key IDs match recipients" << std::endl;
+
     // For each recipient
     for(int i=0; i<numRecipients; i++){
         // Decode the encrypted symmetric key from Base64 into hex and cast to unsigned char*
@@ -112,7 +126,49 @@ int main(){
             return 1;
         }
     }
-    
+
+    // Each recipient decrypts the message through the key named by its ID
+    for(int i=0; i<numRecipients; i++){
+        if(SignedData::decryptSignedMessage(dataJSON, private_keys[i]) != "Hello world!"){
+            std::cerr << "Recipient could not decrypt the message with its key ID!" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Recipients decrypted the message with their key IDs" << std::endl;
+
+    // Only the symmetric key with a matching ID is tried, with the keys swapped neither recipient's own key is under its ID
+    nlohmann::json swapped = dataJSON;
+    std::swap(swapped["symm_keys"][0], swapped["symm_keys"][1]);
+    for(int i=0; i<numRecipients; i++){
+        if(!SignedData::decryptSignedMessage(swapped, private_keys[i]).empty()){
+            std::cerr << "Symmetric key without a matching ID was decrypted!" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Only symmetric keys with matching IDs decrypted" << std::endl;
+
+    // Without key IDs, or with a list that doesn't match the keys, every symmetric key is tried
+    nlohmann::json noIds = swapped;
+    noIds.erase("symm_key_ids");
+    nlohmann::json shortIds = swapped;
+    shortIds["symm_key_ids"].erase(1);
+    for(int i=0; i<numRecipients; i++){
+        if(SignedData::decryptSignedMessage(noIds, private_keys[i]) != "Hello world!" || SignedData::decryptSignedMessage(shortIds, private_keys[i]) != "Hello world!"){
+            std::cerr << "Message without usable key IDs was not decrypted by trying every key!" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Messages without usable key IDs decrypted by trying every key" << std::endl;
+
+    // IDs naming other keys mean the message isn't for this recipient, even though a symmetric key was encrypted with its key
+    nlohmann::json mismatched = dataJSON;
+    mismatched["symm_key_ids"] = {DataMessage::keyId(private_keys[1]), DataMessage::keyId(private_keys[1])};
+    if(!SignedData::decryptSignedMessage(mismatched, private_keys[0]).empty() || SignedData::decryptSignedMessage(mismatched, private_keys[1]) != "Hello world!"){
+        std::cerr << "Message was decrypted under a mismatched key ID!" << std::endl;
+        return 1;
+    }
+    std::cout << "Mismatched key IDs not decrypted" << std::endl;
+
     // Free memory after use
     for(int i=0; i<numRecipients; i++){
         EVP_PKEY_free(public_keys.at(i));
@@ -2,6 +2,7 @@
 #include "../client/client_key_gen.h"
 #include "../client/Sha256Hash.h"
 #include "../client/base64.h"
+#include "../client/fingerprint_digest.h"
 #include <openssl/pem.h>
 #include <string>
 int main(){
@@ -30,5 +31,17 @@ int main(){
     }
     std::cout << "Key and fingerprint match!" << std::endl;
 
+    // Digest parsed from the fingerprint text must match the hash and convert back to the same text
+    FingerprintDigest digest = FingerprintDigest::fromText(finger);
+    if (!digest.valid() || digest != FingerprintDigest::fromHex(hash) || digest.toText() != finger){
+        std::cerr << "Fingerprint digest does not round trip" << std::endl;
+        return -1;
+    }
+    if (FingerprintDigest::fromText("not a fingerprint").valid() || FingerprintDigest::fromText(finger.substr(1) + "=").valid()){
+        std::cerr << "Invalid fingerprint text was parsed" << std::endl;
+        return -1;
+    }
+    std::cout << "Fingerprint digest round trips" << std::endl;
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "../client/key_cache.h"
+#include "../client/client_key_gen.h"
+#include "../client/Fingerprint.h"
+#include <iostream>
+
+int main(){
+    // Generate RSA keys (public and private)
+    if (Client_Key_Gen::key_gen(0, false, true)) {
+        std::cerr << "Key generation failed!" << std::endl;
+        return 1;
+    }
+
+    EVP_PKEY *pubKey = Client_Key_Gen::loadPublicKey("tests/test-keys/public_key0.pem");
+    if (!pubKey) {
+        std::cerr << "Failed to load public key!" << std::endl;
+        return 1;
+    }
+
+    // Convert key to a PEM string
+    BIO * bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PUBKEY(bio, pubKey);
+    char * pemKey = nullptr;
+    long pemLen = BIO_get_mem_data(bio, &pemKey);
+    std::string publicKeyStr(pemKey, pemLen);
+    BIO_free(bio);
+
+    // Repeated lookups must return the same parsed key
+    KeyCache::Handle first = KeyCache::acquire(publicKeyStr);
+    KeyCache::Handle second = KeyCache::get(publicKeyStr);
+    if (!first || first.get() != second.get()) {
+        std::cerr << "Key was parsed more than once!" << std::endl;
+        return -1;
+    }
+    std::cout << "Key parsed once" << std::endl;
+
+    // The cache holds the interned copy of the PEM string rather than its own
+    KeyPool::Key interned = KeyPool::intern(publicKeyStr);
+    if (KeyPool::size() != 1 || interned.use_count() != 2) {
+        std::cerr << "Cache does not share the interned key!" << std::endl;
+        return -1;
+    }
+    interned.reset();
+    std::cout << "Cache shares the interned key" << std::endl;
+
+    // Cached fingerprint must match a freshly generated one
+    std::string fingerprint = Fingerprint::generateFingerprint(pubKey);
+    if (KeyCache::fingerprint(publicKeyStr) != fingerprint || KeyCache::fingerprint(first.get()) != fingerprint) {
+        std::cerr << "Cached fingerprint does not match!" << std::endl;
+        return -1;
+    }
+    std::cout << "Cached fingerprint matches" << std::endl;
+
+    // Releasing the last owner evicts the key, but handles remain usable
+    KeyCache::release(publicKeyStr);
+    if (KeyCache::size() != 0 || KeyPool::size() != 0) {
+        std::cerr << "Key was not evicted!" << std::endl;
+        return -1;
+    }
+    if (Fingerprint::generateFingerprint(first.get()) != fingerprint) {
+        std::cerr << "Handle was freed while still in use!" << std::endl;
+        return -1;
+    }
+    std::cout << "Key evicted after release" << std::endl;
+
+    // Invalid keys return an empty handle rather than aborting
+    if (KeyCache::get("not a key")) {
+        std::cerr << "Invalid key was parsed!" << std::endl;
+        return -1;
+    }
+
+    EVP_PKEY_free(pubKey);
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include "../client/key_pool.h"
+#include <iostream>
+
+int main(){
+    std::string pem = "-----BEGIN PUBLIC KEY-----\n" + std::string(392, 'A') + "\n-----END PUBLIC KEY-----\n";
+
+    // Interning the same string twice must return the same stored copy
+    KeyPool::Key first = KeyPool::intern(pem);
+    KeyPool::Key second = KeyPool::intern(std::string(pem));
+    if (!first || first.get() != second.get() || *first != pem) {
+        std::cerr << "Key was stored more than once!" << std::endl;
+        return -1;
+    }
+    std::cout << "Key stored once" << std::endl;
+
+    // Different keys are stored separately
+    KeyPool::Key other = KeyPool::intern(pem + "B");
+    if (other.get() == first.get() || KeyPool::size() != 2) {
+        std::cerr << "Different keys were merged!" << std::endl;
+        return -1;
+    }
+
+    // Two references to the first key save one copy of it
+    if (KeyPool::bytesStored() != pem.size() * 2 + 1 || KeyPool::bytesSaved() != pem.size()) {
+        std::cerr << "Bytes saved reported incorrectly!" << std::endl;
+        return -1;
+    }
+    std::cout << "Bytes saved reported" << std::endl;
+
+    // Keys are freed once every reference is dropped
+    first.reset();
+    second.reset();
+    if (KeyPool::size() != 1 || KeyPool::bytesSaved() != 0) {
+        std::cerr << "Key was not freed!" << std::endl;
+        return -1;
+    }
+    if (*KeyPool::intern(pem) != pem) {
+        std::cerr << "Freed key could not be interned again!" << std::endl;
+        return -1;
+    }
+    std::cout << "Key freed after last reference" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "../server-files/known_client_registry.h"
+#include "../server-files/mapping_journal.h"
+#include "../client/Sha256Hash.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+static const char* snapshotFile = "tests/test_registry.bin";
+static const char* jsonFile = "tests/test_registry.json";
+static const char* journalFile = "tests/test_registry.journal";
+
+mapping_entry entry(const std::string& public_key, long long last_seen){
+    mapping_entry made;
+    made.public_key = KeyPool::intern(public_key);
+    made.digest = Sha256Hash::hashStringSha256(public_key);
+    made.fingerprint = "fingerprint of " + public_key;
+    made.last_seen = last_seen;
+    return made;
+}
+
+std::vector<int> evict(KnownClientRegistry& registry, const std::set<int>& connected){
+    std::vector<int> evicted;
+    registry.evict([&connected](int client_id){ return connected.count(client_id) > 0; }, evicted);
+    return evicted;
+}
+
+void removeFiles(){
+    std::remove(snapshotFile);
+    std::remove(jsonFile);
+    std::remove(journalFile);
+}
+
+int main(){
+    KnownClientRegistry registry(2);
+    registry.insert(1001, entry("key 1", 100));
+    registry.insert(1002, entry("key 2", 200));
+    registry.insert(1003, entry("key 3", 300));
+
+    // The client not seen for longest is evicted first
+    if (evict(registry, {}) != std::vector<int>({1001}) || registry.size() != 2) {
+        std::cerr << "Least recently seen client was not evicted!" << std::endl;
+        return -1;
+    }
+
+    // Seeing a client moves it to the back of the eviction order
+    registry.seen(1002, 400);
+    registry.insert(1004, entry("key 4", 500));
+    if (evict(registry, {}) != std::vector<int>({1003}) || registry.get(1002)->last_seen != 400) {
+        std::cerr << "Returning client was evicted before an older one!" << std::endl;
+        return -1;
+    }
+    std::cout << "Least recently seen clients evicted" << std::endl;
+
+    // Connected clients are skipped, however long ago they were seen
+    registry.insert(1005, entry("key 5", 600));
+    if (evict(registry, {1002}) != std::vector<int>({1004}) || registry.skippedCount() != 1 || registry.evictedCount() != 3) {
+        std::cerr << "Connected client was evicted!" << std::endl;
+        return -1;
+    }
+    registry.insert(1006, entry("key 6", 700));
+    if (!evict(registry, {1002, 1005, 1006}).empty() || registry.size() != 3) {
+        std::cerr << "Clients were evicted while every one was connected!" << std::endl;
+        return -1;
+    }
+    std::cout << "Connected clients skipped" << std::endl;
+
+    // An evicted client is no longer known, so returning gives them a new ID
+    mapping_entry evictedEntry = entry("key 1", 100);
+    if (registry.find(evictedEntry.digest, evictedEntry.public_key) != -1 || registry.get(1001) != nullptr) {
+        std::cerr << "Evicted client is still known!" << std::endl;
+        return -1;
+    }
+    mapping_entry knownEntry = entry("key 2", 200);
+    if (registry.find(knownEntry.digest, knownEntry.public_key) != 1002) {
+        std::cerr << "Known client was not found!" << std::endl;
+        return -1;
+    }
+
+    // Removals in the journal are replayed on load, and evicted IDs still count towards the highest ID given out
+    removeFiles();
+    std::unordered_map<int, mapping_entry> snapshot;
+    snapshot[1001] = entry("key 1", 100);
+    snapshot[1002] = entry("key 2", 200);
+    MappingSnapshot::save(snapshotFile, snapshot, 1002);
+    std::ofstream journal(journalFile);
+    journal << "{\"client-id\":1003,\"public-key\":\"key 3\",\"digest\":\"" << Sha256Hash::hashStringSha256("key 3") << "\",\"fingerprint\":\"f\",\"last-seen\":50}\n";
+    journal << "{\"client-id\":1001,\"removed\":true}\n";
+    journal << "{\"client-id\":1003,\"removed\":true}\n";
+    journal.close();
+
+    std::unordered_map<int, mapping_entry> loaded;
+    int highest = 0;
+    {
+        MappingJournal replayed(snapshotFile, jsonFile, journalFile);
+        if (!replayed.load(loaded, highest)) {
+            std::cerr << "Mapping could not be loaded!" << std::endl;
+            return -1;
+        }
+    }
+    if (loaded.size() != 1 || loaded.count(1002) != 1 || highest != 1003) {
+        std::cerr << "Journalled removals were not replayed!" << std::endl;
+        return -1;
+    }
+
+    // Loading orders clients by when they were last seen
+    loaded[1007] = entry("key 7", 10);
+    KnownClientRegistry reloaded(1);
+    reloaded.load(loaded);
+    if (evict(reloaded, {}) != std::vector<int>({1007})) {
+        std::cerr << "Loaded clients were not ordered by last seen!" << std::endl;
+        return -1;
+    }
+    std::cout << "Removals replayed and evicted IDs not reused" << std::endl;
+
+    removeFiles();
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "../client/logger.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+
+int main(){
+    // Capture what the logger writes
+    std::ostringstream out, err;
+    std::streambuf* coutBuffer = std::cout.rdbuf(out.rdbuf());
+    std::streambuf* cerrBuffer = std::cerr.rdbuf(err.rdbuf());
+
+    const int threads = 4;
+    const int linesPerThread = 5000;
+    {
+        LogWriter writer;
+
+        // Logged before the ring buffer fills up, so the warning is never dropped
+        LOG_WARN("warning line");
+        LOG_DEBUG("debug line");
+        LOG_PAYLOAD("payload line");
+        Logger::setLevel(Logger::Warn);
+        LOG_INFO("skipped info line");
+        Logger::setLevel(Logger::Info);
+
+        // Lines from several threads at once
+        std::vector<std::thread> producers;
+        for(int t = 0; t < threads; t++){
+            producers.emplace_back([t](){
+                for(int i = 0; i < linesPerThread; i++){
+                    LOG_INFO("thread " << t << " line " << i);
+                }
+            });
+        }
+        for(auto& producer: producers){
+            producer.join();
+        }
+    }
+
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+
+    // Every line that wasn't dropped is written whole, and each thread's lines stay in order
+    std::vector<int> next(threads, 0);
+    std::istringstream lines(out.str());
+    std::string line;
+    size_t written = 0;
+    while(std::getline(lines, line)){
+        int t, i;
+        if(std::sscanf(line.c_str(), "thread %d line %d", &t, &i) != 2 || t < 0 || t >= threads){
+            std::cerr << "Unexpected line \"" << line << "\"" << std::endl;
+            return -1;
+        }
+        if(i < next[t]){
+            std::cerr << "Lines from thread " << t << " out of order!" << std::endl;
+            return -1;
+        }
+        next[t] = i + 1;
+        written++;
+    }
+    if(written + Logger::dropped() != (size_t)(threads * linesPerThread)){
+        std::cerr << "Lines were lost!" << std::endl;
+        return -1;
+    }
+    std::cout << "Lines from every thread written in order" << std::endl;
+
+    // Warnings go to stderr, debug lines aren't compiled in and payloads and skipped levels aren't logged
+    if(err.str().find("warning line\n") == std::string::npos){
+        std::cerr << "Warning was not written to stderr!" << std::endl;
+        return -1;
+    }
+    if(out.str().find("debug line") != std::string::npos || out.str().find("payload line") != std::string::npos || out.str().find("skipped") != std::string::npos){
+        std::cerr << "Line was logged that shouldn't have been!" << std::endl;
+        return -1;
+    }
+    std::cout << "Levels and payload logging respected" << std::endl;
+
+    // Lines logged while the writer stops are either queued before it finishes or written straight away, never lost
+    std::ostringstream stopping;
+    std::cout.rdbuf(stopping.rdbuf());
+    std::cerr.rdbuf(err.rdbuf());
+    size_t droppedBefore = Logger::dropped();
+    {
+        std::vector<std::thread> producers;
+        {
+            LogWriter writer;
+            for(int t = 0; t < threads; t++){
+                producers.emplace_back([t](){
+                    for(int i = 0; i < linesPerThread; i++){
+                        LOG_INFO("thread " << t << " line " << i);
+                    }
+                });
+            }
+        }
+        for(auto& producer: producers){
+            producer.join();
+        }
+    }
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+    written = 0;
+    std::istringstream stoppingLines(stopping.str());
+    while(std::getline(stoppingLines, line)){
+        written++;
+    }
+    if(written + Logger::dropped() - droppedBefore != (size_t)(threads * linesPerThread)){
+        std::cerr << "Lines logged while the writer stopped were lost!" << std::endl;
+        return -1;
+    }
+    std::cout << "Lines logged while the writer stopped written" << std::endl;
+
+    // With no writer running lines are written straight away
+    std::ostringstream direct;
+    std::cout.rdbuf(direct.rdbuf());
+    LOG_INFO("direct line");
+    std::cout.rdbuf(coutBuffer);
+    if(direct.str() != "direct line\n"){
+        std::cerr << "Line was not written without a writer!" << std::endl;
+        return -1;
+    }
+    std::cout << "Lines written without a writer" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "../server-files/mapping_journal.h"
+#include "../client/Sha256Hash.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+static const char* snapshotFile = "tests/test_journal.bin";
+static const char* jsonFile = "tests/test_journal.json";
+static const char* journalFile = "tests/test_journal.journal";
+
+mapping_entry entry(const std::string& public_key, long long last_seen){
+    mapping_entry made;
+    made.public_key = KeyPool::intern(public_key);
+    made.digest = Sha256Hash::hashStringSha256(public_key);
+    made.fingerprint = "fingerprint of " + public_key;
+    made.last_seen = last_seen;
+    return made;
+}
+
+std::string readFile(const std::string& file){
+    std::ifstream in(file);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+bool exists(const std::string& file){
+    return (bool)std::ifstream(file);
+}
+
+// The writer thread journals records in the background, waits until it has written the given number of lines
+bool waitForLines(size_t lines){
+    for(int i = 0; i < 200; i++){
+        std::string journal = readFile(journalFile);
+        if((size_t)std::count(journal.begin(), journal.end(), '\n') >= lines){
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+void removeFiles(){
+    std::remove(snapshotFile);
+    std::remove(jsonFile);
+    std::remove(journalFile);
+}
+
+int main(){
+    removeFiles();
+    std::unordered_map<int, mapping_entry> loaded;
+    int highest = 0;
+
+    // Records are appended to the journal as they are queued
+    std::string journalled;
+    {
+        MappingJournal journal(snapshotFile, jsonFile, journalFile);
+        if (journal.load(loaded, highest) || !loaded.empty() || highest != 0) {
+            std::cerr << "Mapping loaded before anything was written!" << std::endl;
+            return -1;
+        }
+        journal.append(1001, entry("key 1", 100));
+        journal.append(1002, entry("key 2", 200));
+        journal.append(1003, entry("key 3", 300));
+        journal.seen(1001, 400);
+        if (!waitForLines(4)) {
+            std::cerr << "Records were not journalled!" << std::endl;
+            return -1;
+        }
+        journalled = readFile(journalFile);
+        if (exists(snapshotFile)) {
+            std::cerr << "Snapshot was written before the journal was compacted!" << std::endl;
+            return -1;
+        }
+    }
+
+    // Stopping compacts the journal into the snapshot, through a temporary file, and empties the journal
+    int snapshotHighest = 0;
+    if (!MappingSnapshot::load(snapshotFile, loaded, snapshotHighest) || loaded.size() != 3 || snapshotHighest != 1003 || loaded[1001].last_seen != 400) {
+        std::cerr << "Journal was not compacted into the snapshot!" << std::endl;
+        return -1;
+    }
+    if (!readFile(journalFile).empty() || exists(std::string(snapshotFile) + ".tmp")) {
+        std::cerr << "Journal was not emptied after compacting!" << std::endl;
+        return -1;
+    }
+    std::cout << "Journal compacted into the snapshot" << std::endl;
+
+    // A crash before compacting leaves only the journal, a record cut off part way through being written is skipped
+    std::remove(snapshotFile);
+    std::ofstream torn(journalFile, std::ios::trunc);
+    torn << journalled << "{\"client-id\":1004,\"public-key\":\"key";
+    torn.close();
+    loaded.clear();
+    {
+        MappingJournal journal(snapshotFile, jsonFile, journalFile);
+        if (!journal.load(loaded, highest)) {
+            std::cerr << "Journal was not loaded!" << std::endl;
+            return -1;
+        }
+    }
+    if (loaded.size() != 3 || highest != 1003 || loaded.count(1004) != 0) {
+        std::cerr << "Journal was replayed incorrectly!" << std::endl;
+        return -1;
+    }
+    if (*loaded[1002].public_key != "key 2" || loaded[1002].digest != Sha256Hash::hashStringSha256("key 2") || loaded[1001].last_seen != 400) {
+        std::cerr << "Replayed client differs from the one journalled!" << std::endl;
+        return -1;
+    }
+    std::cout << "Journal replayed, torn last record skipped" << std::endl;
+
+    // The snapshot is rewritten once enough records have been journalled
+    removeFiles();
+    {
+        MappingJournal journal(snapshotFile, jsonFile, journalFile, 2);
+        journal.load(loaded, highest);
+        journal.append(1001, entry("key 1", 100));
+        journal.append(1002, entry("key 2", 200));
+        bool compacted = false;
+        for (int i = 0; i < 200 && !compacted; i++) {
+            compacted = exists(snapshotFile) && readFile(journalFile).empty();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if (!compacted) {
+            std::cerr << "Journal was not compacted after compact_every records!" << std::endl;
+            return -1;
+        }
+    }
+    std::cout << "Journal compacted after compact_every records" << std::endl;
+
+    removeFiles();
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "../server-files/mapping_snapshot.h"
+#include "../client/Sha256Hash.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static const char* snapshotFile = "tests/test_mapping.bin";
+static const char* jsonFile = "tests/test_mapping.json";
+
+mapping_entry entry(const std::string& public_key, long long last_seen){
+    mapping_entry made;
+    made.public_key = KeyPool::intern(public_key);
+    made.digest = Sha256Hash::hashStringSha256(public_key);
+    made.fingerprint = "fingerprint of " + public_key;
+    made.last_seen = last_seen;
+    return made;
+}
+
+bool sameMapping(const std::unordered_map<int, mapping_entry>& a, const std::unordered_map<int, mapping_entry>& b){
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (const auto& client: a) {
+        auto other = b.find(client.first);
+        if (other == b.end() || *other->second.public_key != *client.second.public_key || other->second.digest != client.second.digest ||
+            other->second.fingerprint != client.second.fingerprint || other->second.last_seen != client.second.last_seen) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(){
+    std::unordered_map<int, mapping_entry> mapping;
+    mapping[1001] = entry("-----BEGIN PUBLIC KEY-----\nfirst\n-----END PUBLIC KEY-----\n", 1700000000);
+    mapping[1002] = entry("-----BEGIN PUBLIC KEY-----\nsecond\n-----END PUBLIC KEY-----\n", 1700000100);
+    mapping[1005] = entry("-----BEGIN PUBLIC KEY-----\nthird\n-----END PUBLIC KEY-----\n", 1700000200);
+
+    // The highest ID given out is kept even if that client has since been evicted
+    if (!MappingSnapshot::save(snapshotFile, mapping, 1010)) {
+        std::cerr << "Snapshot could not be saved!" << std::endl;
+        return -1;
+    }
+    std::unordered_map<int, mapping_entry> loaded;
+    int highest = 0;
+    if (!MappingSnapshot::load(snapshotFile, loaded, highest) || !sameMapping(mapping, loaded) || highest != 1010) {
+        std::cerr << "Snapshot did not load as it was saved!" << std::endl;
+        return -1;
+    }
+    if (loaded[1002].public_key != mapping[1002].public_key) {
+        std::cerr << "Loaded key was not interned!" << std::endl;
+        return -1;
+    }
+    std::cout << "Snapshot saved and loaded" << std::endl;
+
+    // Truncated snapshots fail to load and leave the mapping as it was
+    std::ifstream in(snapshotFile, std::ios::binary);
+    std::string saved((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ostringstream errors;
+    std::streambuf* stderrBuffer = std::cerr.rdbuf(errors.rdbuf()); // Each failed load logs why
+    for (size_t length = 0; length < saved.size(); length++) {
+        std::ofstream out(snapshotFile, std::ios::binary | std::ios::trunc);
+        out.write(saved.data(), length);
+        out.close();
+        if (MappingSnapshot::load(snapshotFile, loaded, highest) || !sameMapping(mapping, loaded)) {
+            std::cerr.rdbuf(stderrBuffer);
+            std::cerr << "Snapshot truncated to " << length << " bytes was loaded!" << std::endl;
+            return -1;
+        }
+    }
+    std::cerr.rdbuf(stderrBuffer);
+
+    // A corrupt record count fails to load rather than reserving for it
+    std::string corrupt = saved;
+    uint32_t count = 0xffffffff;
+    corrupt.replace(12, sizeof(count), reinterpret_cast<const char*>(&count), sizeof(count));
+    std::ofstream out(snapshotFile, std::ios::binary | std::ios::trunc);
+    out << corrupt;
+    out.close();
+    if (MappingSnapshot::load(snapshotFile, loaded, highest)) {
+        std::cerr << "Snapshot with a corrupt record count was loaded!" << std::endl;
+        return -1;
+    }
+    std::cout << "Truncated and corrupt snapshots rejected" << std::endl;
+
+    // The JSON mapping file keeps the keys, importing works out each key's digest
+    if (!MappingSnapshot::exportJson(jsonFile, mapping)) {
+        std::cerr << "Mapping could not be exported!" << std::endl;
+        return -1;
+    }
+    std::unordered_map<int, mapping_entry> imported;
+    if (!MappingSnapshot::importJson(jsonFile, imported, highest) || imported.size() != mapping.size() || highest != 1005) {
+        std::cerr << "Mapping did not import as it was exported!" << std::endl;
+        return -1;
+    }
+    for (const auto& client: mapping) {
+        if (*imported[client.first].public_key != *client.second.public_key || imported[client.first].digest != client.second.digest) {
+            std::cerr << "Imported client " << client.first << " differs!" << std::endl;
+            return -1;
+        }
+    }
+
+    out.open(jsonFile, std::ios::trunc);
+    out << "[[1001, \"key\"], [1002";
+    out.close();
+    if (MappingSnapshot::importJson(jsonFile, imported, highest)) {
+        std::cerr << "Truncated mapping file was imported!" << std::endl;
+        return -1;
+    }
+    std::cout << "Mapping exported and imported" << std::endl;
+
+    std::remove(snapshotFile);
+    std::remove(jsonFile);
+    return 0;
+}
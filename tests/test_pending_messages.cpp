@@ -0,0 +1,81 @@
+#include "../server-files/server_utilities.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Receives a message the way on_message does, waiting behind the signature being verified if it has to
+void receive(connection_data& con_data, bool confirmed_client, const nlohmann::json& message, std::vector<std::string>& handled){
+    std::string name = message.is_object() && message["type"].is_string() ? message["type"].get<std::string>() : message.dump();
+    if(con_data.waits_for_verification(message, confirmed_client)){
+        con_data.pending_messages.push_back([name, &handled](){
+            handled.push_back(name);
+        });
+        return;
+    }
+    handled.push_back(name);
+}
+
+// Finishes verifying a message the way verify_then does, then handles the messages that waited for it in order
+void verified(connection_data& con_data, const std::string& name, std::vector<std::string>& handled){
+    con_data.verifying = false;
+    handled.push_back(name);
+    while(!con_data.verifying && !con_data.pending_messages.empty()){
+        std::function<void()> pending = con_data.pending_messages.front();
+        con_data.pending_messages.pop_front();
+        pending();
+    }
+}
+
+int main(){
+    nlohmann::json clientListRequest = {{"type", "client_list_request"}};
+    nlohmann::json publicChat = {{"type", "signed_data"}, {"data", "{\"type\":\"public_chat\"}"}, {"counter", 2}, {"signature", "c2ln"}};
+
+    // A client list request sent straight after a hello waits for the hello, so the client is in the client_server_map
+    connection_data hello;
+    hello.verifying = true;
+    std::vector<std::string> handled;
+    receive(hello, false, clientListRequest, handled);
+    if (!handled.empty()) {
+        std::cerr << "Client list request was answered before the hello was verified!" << std::endl;
+        return -1;
+    }
+    verified(hello, "hello", handled);
+    if (handled != std::vector<std::string>({"hello", "client_list_request"})) {
+        std::cerr << "Client list request was not answered after the hello!" << std::endl;
+        return -1;
+    }
+    std::cout << "Client list request waits for the hello" << std::endl;
+
+    // Once the client is confirmed a client list request never waits behind its signed messages
+    connection_data client;
+    client.verifying = true;
+    handled.clear();
+    receive(client, true, publicChat, handled);
+    receive(client, true, publicChat, handled);
+    receive(client, true, clientListRequest, handled);
+    if (handled != std::vector<std::string>({"client_list_request"}) || client.pending_messages.size() != 2) {
+        std::cerr << "Client list request waited behind signed messages!" << std::endl;
+        return -1;
+    }
+    verified(client, "signed_data", handled);
+    if (handled != std::vector<std::string>({"client_list_request", "signed_data", "signed_data", "signed_data"})) {
+        std::cerr << "Signed messages were not handled in order!" << std::endl;
+        return -1;
+    }
+    std::cout << "Client list request answered before signed messages being verified" << std::endl;
+
+    // Nothing waits while no signature is being verified, and malformed types wait like any other message
+    handled.clear();
+    receive(client, true, publicChat, handled);
+    receive(client, false, clientListRequest, handled);
+    client.verifying = true;
+    receive(client, true, nlohmann::json({{"type", 5}}), handled);
+    receive(client, true, nlohmann::json::array(), handled);
+    if (handled != std::vector<std::string>({"signed_data", "client_list_request"}) || client.pending_messages.size() != 2) {
+        std::cerr << "Messages waited with nothing being verified, or malformed messages skipped the queue!" << std::endl;
+        return -1;
+    }
+    std::cout << "Only messages behind a signature being verified wait" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "../client/replay_window.h"
+#include "../client/Sha256Hash.h"
+#include <iostream>
+
+int main(){
+    ReplayWindow window(2);
+
+    // Senders are identified by the digest of their fingerprint
+    FingerprintDigest alice = FingerprintDigest::fromHex(Sha256Hash::hashStringSha256("alice"));
+    FingerprintDigest bob = FingerprintDigest::fromHex(Sha256Hash::hashStringSha256("bob"));
+    FingerprintDigest carol = FingerprintDigest::fromHex(Sha256Hash::hashStringSha256("carol"));
+
+    // Counter 0 is treated as already seen, counters start at 1
+    if (window.check(alice, 0)) {
+        std::cerr << "Counter 0 was accepted!" << std::endl;
+        return -1;
+    }
+
+    if (!window.check(alice, 1) || !window.check(alice, 2)) {
+        std::cerr << "New counters were rejected!" << std::endl;
+        return -1;
+    }
+
+    // Repeated counter must be rejected
+    if (window.check(alice, 2)) {
+        std::cerr << "Replayed counter was accepted!" << std::endl;
+        return -1;
+    }
+    std::cout << "Replayed counter rejected" << std::endl;
+
+    // Counters that arrive out of order within the window are accepted once
+    if (!window.check(alice, 10) || !window.check(alice, 5) || window.check(alice, 5)) {
+        std::cerr << "Out of order counters were not handled!" << std::endl;
+        return -1;
+    }
+    std::cout << "Out of order counters accepted once" << std::endl;
+
+    // Counters older than the window must be rejected
+    if (!window.check(alice, 10 + ReplayWindow::windowSize) || window.check(alice, 10)) {
+        std::cerr << "Counter older than the window was accepted!" << std::endl;
+        return -1;
+    }
+
+    // Counters are tracked per sender
+    if (!window.check(bob, 2)) {
+        std::cerr << "Counter from a different sender was rejected!" << std::endl;
+        return -1;
+    }
+
+    // Only two senders are tracked, alice was seen least recently so her window is dropped
+    window.check(carol, 1);
+    if (window.size() != 2) {
+        std::cerr << "Least recently seen sender was not dropped!" << std::endl;
+        return -1;
+    }
+
+    // A dropped sender's highest counter is kept, so her old counters are still rejected and only newer ones accepted
+    if (window.check(alice, 10 + ReplayWindow::windowSize) || window.check(alice, 1) || !window.check(alice, 11 + ReplayWindow::windowSize)) {
+        std::cerr << "Dropped sender's counters were forgotten!" << std::endl;
+        return -1;
+    }
+    std::cout << "Senders bounded without forgetting their counters" << std::endl;
+
+    // Negative counters are never accepted
+    ReplayWindow fresh;
+    if (fresh.check(alice, -1) || !fresh.check(alice, 1) || fresh.check(alice, -1)) {
+        std::cerr << "Negative counter was accepted!" << std::endl;
+        return -1;
+    }
+
+    // A client reconnecting (or restarting, its counter starts from the clock) keeps counting up from its last session,
+    // so its hello and chats from the earlier session can't be replayed
+    ReplayWindow sessions;
+    int firstSession = 1700000000;
+    if (!sessions.check(alice, firstSession) || !sessions.check(alice, firstSession + 1)) {
+        std::cerr << "First session's counters were rejected!" << std::endl;
+        return -1;
+    }
+    int secondSession = firstSession + 60;
+    if (!sessions.check(alice, secondSession) || !sessions.check(alice, secondSession + 1)) {
+        std::cerr << "Reconnected client's counters were rejected!" << std::endl;
+        return -1;
+    }
+    if (sessions.check(alice, firstSession) || sessions.check(alice, firstSession + 1) || sessions.check(alice, secondSession)) {
+        std::cerr << "Message from an earlier session was accepted after reconnecting!" << std::endl;
+        return -1;
+    }
+    std::cout << "Messages from earlier sessions rejected after reconnecting" << std::endl;
+
+    return 0;
+}
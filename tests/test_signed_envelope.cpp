@@ -0,0 +1,73 @@
+#include "../client/signed_envelope.h"
+#include "../client/client_signature.h"
+#include "../client/client_key_gen.h"
+#include <iostream>
+
+int main(){
+    // Generate RSA keys (public and private)
+    if (Client_Key_Gen::key_gen(0, false, true)) {
+        std::cerr << "Key generation failed!" << std::endl;
+        return 1;
+    }
+
+    EVP_PKEY *privKey = Client_Key_Gen::loadPrivateKey("tests/test-keys/private_key0.pem");
+    EVP_PKEY *pubKey = Client_Key_Gen::loadPublicKey("tests/test-keys/public_key0.pem");
+    if (!privKey || !pubKey) {
+        std::cerr << "Failed to load keys!" << std::endl;
+        return 1;
+    }
+
+    // Data string with unsorted keys and extra whitespace, re-serialising it would change the signed bytes
+    std::string data = "{\"type\": \"public_chat\", \"sender\": \"abc\", \"message\": \"Hello\"}";
+    int counter = 12345;
+
+    nlohmann::json message;
+    message["type"] = "signed_data";
+    message["data"] = data;
+    message["counter"] = counter;
+    message["signature"] = ClientSignature::generateSignature(data, privKey, std::to_string(counter));
+
+    SignedEnvelope envelope;
+    if (!envelope.parse(message.dump())) {
+        std::cerr << "Failed to parse signed message!" << std::endl;
+        return -1;
+    }
+
+    if (!envelope.isSigned() || envelope.counter() != counter) {
+        std::cerr << "Signature or counter missing from parsed message!" << std::endl;
+        return -1;
+    }
+
+    if (envelope.rawData() != data || envelope.data["type"] != "public_chat") {
+        std::cerr << "Data field was not preserved!" << std::endl;
+        return -1;
+    }
+
+    if (!ClientSignature::verifySignature(envelope.signature(), envelope.signedBytes(), pubKey)) {
+        std::cerr << "Signature verification over received bytes failed!" << std::endl;
+        return -1;
+    }
+    std::cout << "Signature verified over received bytes" << std::endl;
+
+    // A modified data field must not verify
+    message["data"] = "{\"type\": \"public_chat\", \"sender\": \"abc\", \"message\": \"Hellp\"}";
+    SignedEnvelope tampered;
+    tampered.parse(message.dump());
+    if (ClientSignature::verifySignature(tampered.signature(), tampered.signedBytes(), pubKey)) {
+        std::cerr << "Tampered message was verified!" << std::endl;
+        return -1;
+    }
+    std::cout << "Tampered message rejected" << std::endl;
+
+    // Invalid JSON must be rejected
+    SignedEnvelope invalid;
+    if (invalid.parse("{not json")) {
+        std::cerr << "Invalid JSON was accepted!" << std::endl;
+        return -1;
+    }
+
+    EVP_PKEY_free(privKey);
+    EVP_PKEY_free(pubKey);
+
+    return 0;
+}
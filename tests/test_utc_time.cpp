@@ -0,0 +1,68 @@
+#include "../client/utc_time.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+
+int main(){
+    // Known timestamps
+    std::time_t time;
+    if(!UtcTime::parse("1970-01-01T00:00:00Z", time) || time != 0){
+        std::cerr << "Epoch was not parsed!" << std::endl;
+        return -1;
+    }
+    if(!UtcTime::parse("2024-02-29T23:59:59Z", time) || time != 1709251199){
+        std::cerr << "Leap day was not parsed!" << std::endl;
+        return -1;
+    }
+    if(UtcTime::format(1709251199) != "2024-02-29T23:59:59Z" || UtcTime::format(0) != "1970-01-01T00:00:00Z"){
+        std::cerr << "Timestamps were not formatted!" << std::endl;
+        return -1;
+    }
+    std::cout << "Known timestamps parsed and formatted" << std::endl;
+
+    // Every formatted time parses back to itself, and matches std::gmtime
+    std::srand(1);
+    for(int i = 0; i < 100000; i++){
+        std::time_t original = (std::time_t)(((long long)std::rand() * 7919 + std::rand()) % 8000000000LL);
+        std::string timestamp = UtcTime::format(original);
+
+        char expected[32];
+        std::strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&original));
+        if(timestamp != expected){
+            std::cerr << "Formatted " << timestamp << " instead of " << expected << std::endl;
+            return -1;
+        }
+        if(!UtcTime::parse(timestamp, time) || time != original){
+            std::cerr << "Timestamp " << timestamp << " did not parse back!" << std::endl;
+            return -1;
+        }
+    }
+    std::cout << "Formatted times parse back" << std::endl;
+
+    // Timestamps not in the expected form are rejected
+    const char* invalid[] = {"", "2024-02-29T23:59:59", "2024-02-29 23:59:59Z", "2023-02-29T00:00:00Z", "2024-13-01T00:00:00Z",
+                             "2024-00-01T00:00:00Z", "2024-01-01T24:00:00Z", "2024-01-01T00:60:00Z", "2024-1-01T00:00:00Z",
+                             "2024-01-01T00:00:00Z ", "abcd-01-01T00:00:00Z", "2024-04-31T00:00:00Z"};
+    for(const char* text: invalid){
+        if(UtcTime::parse(text, time)){
+            std::cerr << "Invalid timestamp \"" << text << "\" was accepted!" << std::endl;
+            return -1;
+        }
+    }
+    std::cout << "Invalid timestamps rejected" << std::endl;
+
+    // The cached clock stays within an interval of the system clock
+    {
+        UtcClock clock(10);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        long long drift = (long long)UtcTime::now() - (long long)std::time(nullptr);
+        if(drift < -1 || drift > 1){
+            std::cerr << "Cached clock is out of date!" << std::endl;
+            return -1;
+        }
+    }
+    std::cout << "Cached clock kept up to date" << std::endl;
+
+    return 0;
+}
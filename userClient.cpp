@@ -43,6 +43,7 @@
 #include <websocketpp/common/memory.hpp>
 
 #include <cstdlib>
+#include <ctime>
 #include <iostream>
 #include <map>
 #include <string>
@@ -56,6 +57,7 @@
 #include "client/client_key_gen.h" // OpenSSL Key generation
 #include "client/client_utilities.h" // For sending messages, checking connections
 #include "client/Fingerprint.h" // For fingerprint generation
+#include "client/key_cache.h" // For parsed public keys
 
 // Used to differentiate client processses locally
 const int ClientNumber = 1;
@@ -81,8 +83,9 @@ std::ostream & operator<< (std::ostream & out, connection_metadata const & data)
 }
 
 int main() {
-    // Initialise counter
-    int counter = 0;
+    // Initialise counter from the clock, so it starts above the counters sent by earlier runs with the same keys
+    // (servers and clients remember them to reject replays) as long as they sent less than one message a second
+    int counter = (int)std::time(nullptr);
     int numConnections=0;
     // Load keys
     privKey = Client_Key_Gen::loadPrivateKey(privFileName.c_str());
@@ -271,6 +274,7 @@ int main() {
                             std::vector<EVP_PKEY*> list_public_keys;
                             std::vector<std::string> destination_servers;
                             std::vector<std::string> public_keys_strings;
+                            std::vector<KeyCache::Handle> public_key_handles; // Keeps recipient keys alive while the message is composed
 
                             // Loop to continue querying for clients
                             while (!clientsEntered) {
@@ -344,16 +348,21 @@ int main() {
                                 }
                                 
                                 // Compare fingerprint to this user's fingerprint to determine if the user is trying to send a message to themselves
-                                std::string genFingerprint = Fingerprint::generateFingerprint(Client_Key_Gen::stringToPEM(public_key));
+                                std::string genFingerprint = KeyCache::fingerprint(public_key);
                                 if(fingerprint == genFingerprint){
                                     std::cout << "You cannot be a recipient of your own message" << std::endl;
                                     continue;
                                 }
 
                                 // Push keys to vectors and obtain destination server using serverID and push to vector
+                                KeyCache::Handle public_key_handle = KeyCache::get(public_key);
+                                if(!public_key_handle){
+                                    continue;
+                                }
                                 public_keys_strings.push_back(public_key);
                                 destination_servers.push_back(global_client_list->retrieveAddress(serverInt));
-                                list_public_keys.push_back(Client_Key_Gen::stringToPEM(public_key));
+                                public_key_handles.push_back(public_key_handle);
+                                list_public_keys.push_back(public_key_handle.get());
 
                                 // Check whether user has finished selecting their clients
                                 bool validYesNo = false;